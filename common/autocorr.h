@@ -0,0 +1,217 @@
+#ifndef AUTOCORR_H
+#define AUTOCORR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * Integrated autocorrelation time of an observable streamed from one long run of a chain,
+ * tau_int = 1/2 + sum_{t >= 1} rho(t), in units of the sampling interval. Two estimators:
+ * the FFT autocorrelation summed up to Sokal's automatic window (the smallest M with M >= c tau_int(M)),
+ * which needs the samples, and online batch means, which needs O(1) memory: with batches of size b,
+ * Var(batch mean) ~ 2 tau_int Var(x) / b. Batches are merged pairwise whenever there are 2 * BATCHES
+ * of them, so their size grows with the run.
+ */
+
+#define BATCHES 64
+//Sokal's window constant
+#define WINDOW_C 6.0
+
+typedef struct series{
+	//samples kept for the FFT estimator, NULL when only batch means are wanted
+	double *x;
+	size_t len;
+	size_t cap;
+	int store;
+	//samples to drop at the start as burn in
+	size_t skip;
+	size_t seen;
+	//running mean and variance (Welford)
+	unsigned long long count;
+	double mean;
+	double m2;
+	//online batch means
+	double batch_sum[2 * BATCHES];
+	int batches;
+	unsigned long long batch;
+	double current_sum;
+	unsigned long long current_len;
+} series;
+
+/**
+ * Start an empty series
+ * @param s     The series
+ * @param store Whether to keep the samples for the FFT estimator
+ * @param skip  The number of leading samples to drop
+ */
+static inline void series_init(series *s, int store, size_t skip){
+	memset(s, 0, sizeof(series));
+	s->store = store;
+	s->skip = skip;
+	s->batch = 1;
+}
+
+/**
+ * Free the stored samples
+ * @param s The series
+ */
+static inline void series_free(series *s){
+	free(s->x);
+	s->x = NULL;
+	s->len = s->cap = 0;
+}
+
+/**
+ * Append one sample
+ * @param s The series
+ * @param v The sample
+ */
+static inline void series_push(series *s, double v){
+	if(s->seen++ < s->skip){
+		return;
+	}
+	if(s->store){
+		if(s->len == s->cap){
+			s->cap = s->cap ? 2 * s->cap : 4096;
+			s->x = realloc(s->x, s->cap * sizeof(double));
+			if(NULL == s->x){
+				printf("Out of memory storing the series\n");
+				exit(1);
+			}
+		}
+		s->x[s->len++] = v;
+	}
+	s->count++;
+	double delta = v - s->mean;
+	s->mean += delta / s->count;
+	s->m2 += delta * (v - s->mean);
+
+	s->current_sum += v;
+	if(++s->current_len == s->batch){
+		s->batch_sum[s->batches++] = s->current_sum;
+		s->current_sum = 0;
+		s->current_len = 0;
+		if(s->batches == 2 * BATCHES){
+			for(int i = 0; i < BATCHES; i++){
+				s->batch_sum[i] = s->batch_sum[2 * i] + s->batch_sum[2 * i + 1];
+			}
+			s->batches = BATCHES;
+			s->batch *= 2;
+		}
+	}
+}
+
+/**
+ * In place iterative radix 2 FFT
+ * @param re      Real parts
+ * @param im      Imaginary parts
+ * @param len     The length, a power of 2
+ * @param inverse 1 for the inverse transform (unscaled)
+ */
+static inline void fft(double *re, double *im, size_t len, int inverse){
+	for(size_t i = 1, j = 0; i < len; i++){
+		size_t bit = len >> 1;
+		for(; j & bit; bit >>= 1){
+			j ^= bit;
+		}
+		j ^= bit;
+		if(i < j){
+			double tr = re[i], ti = im[i];
+			re[i] = re[j];
+			im[i] = im[j];
+			re[j] = tr;
+			im[j] = ti;
+		}
+	}
+	for(size_t size = 2; size <= len; size <<= 1){
+		double angle = (inverse ? 2 : -2) * M_PI / size;
+		double wr = cos(angle), wi = sin(angle);
+		for(size_t start = 0; start < len; start += size){
+			double cr = 1, ci = 0;
+			for(size_t k = 0; k < size / 2; k++){
+				size_t a = start + k, b = a + size / 2;
+				double tr = re[b] * cr - im[b] * ci;
+				double ti = re[b] * ci + im[b] * cr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+				double next = cr * wr - ci * wi;
+				ci = cr * wi + ci * wr;
+				cr = next;
+			}
+		}
+	}
+}
+
+/**
+ * Integrated autocorrelation time from the FFT autocorrelation with automatic windowing
+ * @param  s      The series, must have been stored
+ * @param  window Set to the chosen window M, or -1 if the series is too short for the window to close
+ * @return        tau_int in samples, NAN without samples or variance
+ */
+static inline double series_tau_fft(const series *s, long *window){
+	*window = -1;
+	if(s->len < 2){
+		return NAN;
+	}
+	size_t len = 1;
+	while(len < 2 * s->len){
+		len <<= 1;
+	}
+	double *re = calloc(len, sizeof(double));
+	double *im = calloc(len, sizeof(double));
+	if(NULL == re || NULL == im){
+		printf("Out of memory in the autocorrelation\n");
+		exit(1);
+	}
+	for(size_t i = 0; i < s->len; i++){
+		re[i] = s->x[i] - s->mean;
+	}
+	fft(re, im, len, 0);
+	for(size_t i = 0; i < len; i++){
+		re[i] = re[i] * re[i] + im[i] * im[i];
+		im[i] = 0;
+	}
+	fft(re, im, len, 1);
+	double tau = NAN;
+	if(re[0] > 0){
+		tau = 0.5;
+		for(size_t m = 1; m < s->len; m++){
+			tau += re[m] / re[0];
+			if(m >= WINDOW_C * tau){
+				*window = m;
+				break;
+			}
+		}
+	}
+	free(re);
+	free(im);
+	return tau;
+}
+
+/**
+ * Integrated autocorrelation time from the online batch means
+ * @param  s The series
+ * @return   tau_int in samples, NAN before there are enough batches or without variance
+ */
+static inline double series_tau_batch(const series *s){
+	if(s->batches < BATCHES || s->count < 2 || s->m2 <= 0){
+		return NAN;
+	}
+	double mean = 0, var = 0;
+	for(int i = 0; i < s->batches; i++){
+		mean += s->batch_sum[i] / s->batch;
+	}
+	mean /= s->batches;
+	for(int i = 0; i < s->batches; i++){
+		double d = s->batch_sum[i] / s->batch - mean;
+		var += d * d;
+	}
+	var /= s->batches - 1;
+	return s->batch * var / (2 * s->m2 / (s->count - 1));
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "trial.h"
+
+/**
+ * On disk trial cache shared by every sweep run from the same directory. A trial is addressed by the
+ * hash of its key "model engine_version n param seed index"; since its random stream depends only on
+ * the seed, the parameter and the trial index (see trial_stream), a trial that was already run by an
+ * overlapping sweep is read back instead of rerun. Entries are one small file each, cache/<hash>,
+ * holding the key (checked on lookup) and "iterations censored last_disagreement max_steps". They are
+ * written to a temporary name and renamed, so shards on a shared filesystem can fill one cache.
+ * Bump a kernel's engine_version whenever its output for a given seed changes. The directory is
+ * $MCS_CACHE (default cache), MCS_CACHE=off turns the cache off.
+ */
+
+typedef struct cache{
+	int enabled;
+	char dir[256];
+	const char *model;
+	int version;
+	long long n;
+	uint64_t seed;
+	//shared by the batch runner's workers
+	atomic_ullong hits;
+	atomic_ullong misses;
+} cache;
+
+/**
+ * Set up the cache for one sweep
+ * @param c       The cache
+ * @param model   The model, the results prefix of the kernel
+ * @param version The engine version of the kernel
+ * @param n       The size of the graph
+ * @param seed    The sweep seed
+ */
+static inline void cache_open(cache *c, const char *model, int version, long long n, uint64_t seed){
+	const char *dir = getenv("MCS_CACHE");
+	memset(c, 0, sizeof(cache));
+	atomic_init(&c->hits, 0);
+	atomic_init(&c->misses, 0);
+	c->enabled = dir == NULL || strcmp(dir, "off") != 0;
+	snprintf(c->dir, sizeof(c->dir), "%s", dir != NULL && dir[0] != '\0' ? dir : "cache");
+	c->model = model;
+	c->version = version;
+	c->n = n;
+	c->seed = seed;
+	if(c->enabled && mkdir(c->dir, 0755) != 0 && access(c->dir, W_OK) != 0){
+		printf("Trial cache %s is not writable, running without it\n", c->dir);
+		c->enabled = 0;
+	}
+}
+
+/**
+ * Key and file of one trial
+ * @param c     The cache
+ * @param param The parameter, as results files print it
+ * @param index The trial index for this parameter
+ * @param key   Set to the key
+ * @param path  Set to the entry file
+ */
+static inline void cache_entry(const cache *c, double param, int index, char key[256], char path[512]){
+	snprintf(key, 256, "%s %d %lld %f %llu %d", c->model, c->version, c->n, param, (unsigned long long)c->seed, index);
+	//FNV-1a
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for(const char *k = key; *k != '\0'; k++){
+		h = (h ^ (unsigned char)*k) * 0x100000001b3ULL;
+	}
+	snprintf(path, 512, "%s/%016llx", c->dir, (unsigned long long)h);
+}
+
+/**
+ * Read the entry of one trial
+ * @param  path         The entry file
+ * @param  key          The key it must hold
+ * @param  iterations   Set to the iterations it ran
+ * @param  censored     Set to whether it was censored
+ * @param  disagreement Set to the disagreement it stopped at
+ * @param  max_steps    Set to the step budget it ran with
+ * @return              1 if the entry exists and holds the key
+ */
+static inline int cache_read(const char *path, const char *key, unsigned long long *iterations, int *censored,
+		long long *disagreement, unsigned long long *max_steps){
+	char stored[256];
+	FILE *f = fopen(path, "r");
+	if(f == NULL){
+		return 0;
+	}
+	int found = fgets(stored, sizeof(stored), f) != NULL && strncmp(stored, key, strlen(key)) == 0 && stored[strlen(key)] == '\n'
+			&& fscanf(f, "%llu %d %lld %llu", iterations, censored, disagreement, max_steps) == 4;
+	fclose(f);
+	return found;
+}
+
+/**
+ * Look a trial up. A coupled trial answers any budget it fits in, a trial censored by the step budget
+ * only the same budget.
+ * @param  c          The cache
+ * @param  param      The parameter
+ * @param  index      The trial index for this parameter
+ * @param  t          The trial, its budget is read and on a hit its outcome is set
+ * @param  iterations Set to the iterations on a hit
+ * @return            1 on a hit
+ */
+static inline int cache_lookup(cache *c, double param, int index, trial *t, unsigned long long *iterations){
+	if(!c->enabled){
+		return 0;
+	}
+	char key[256], path[512];
+	cache_entry(c, param, index, key, path);
+	int hit = 0;
+	unsigned long long its, max_steps;
+	int censored;
+	long long disagreement;
+	if(cache_read(path, key, &its, &censored, &disagreement, &max_steps)){
+		hit = censored ? max_steps == t->max_steps : t->max_steps == 0 || its <= t->max_steps;
+		if(hit){
+			*iterations = its;
+			t->censored = censored;
+			t->last_disagreement = censored ? disagreement : 0;
+		}
+	}
+	if(hit){
+		c->hits++;
+	}
+	else{
+		c->misses++;
+	}
+	return hit;
+}
+
+/**
+ * Store a finished trial. Trials stopped by the wall clock are not reproducible and are not stored, and a
+ * censored trial never replaces a coupled one, which answers more budgets.
+ * @param c          The cache
+ * @param param      The parameter
+ * @param index      The trial index for this parameter
+ * @param t          The finished trial
+ * @param iterations The iterations it ran
+ */
+static inline void cache_store(const cache *c, double param, int index, const trial *t, unsigned long long iterations){
+	if(!c->enabled || (t->censored && (t->max_steps == 0 || iterations < t->max_steps))){
+		return;
+	}
+	char key[256], path[512], tmp[540];
+	cache_entry(c, param, index, key, path);
+	unsigned long long its, max_steps;
+	int censored;
+	long long disagreement;
+	if(t->censored && cache_read(path, key, &its, &censored, &disagreement, &max_steps) && !censored){
+		return;
+	}
+	//unique per process and per worker thread
+	snprintf(tmp, sizeof(tmp), "%s.%d.%p.tmp", path, (int)getpid(), (void *)t);
+	FILE *f = fopen(tmp, "w");
+	if(NULL == f){
+		return;
+	}
+	fprintf(f, "%s\n%llu %d %lld %llu\n", key, iterations, t->censored, t->last_disagreement, t->max_steps);
+	fclose(f);
+	rename(tmp, path);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef CENSOR_H
+#define CENSOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Coupling times of budget capped trials are right censored: a censored trial only tells us the
+ * coupling time is larger than the budget. A plain mean of such data is biased low, so the sweeps
+ * summarize each parameter with the Kaplan-Meier estimate of the survival function
+ * S(t) = P(coupling time > t) and its median.
+ */
+
+typedef struct observation{
+	unsigned long long time;
+	int censored;
+} observation;
+
+/**
+ * qsort comparator, by time with events before censorings at equal times
+ */
+static inline int observation_compare(const void *a, const void *b){
+	const observation *x = a;
+	const observation *y = b;
+	if(x->time != y->time){
+		return x->time < y->time ? -1 : 1;
+	}
+	return x->censored - y->censored;
+}
+
+/**
+ * Kaplan-Meier median of the observations, sorts obs in place
+ * @param  obs   The observations
+ * @param  count The number of observations
+ * @return       The smallest time with S(t) <= 1/2, or -1 if the survival curve never gets there
+ */
+static inline double km_median(observation *obs, int count){
+	qsort(obs, count, sizeof(observation), observation_compare);
+	double survival = 1;
+	int at_risk = count;
+	for(int i = 0; i < count; i++){
+		if(!obs[i].censored){
+			survival *= (at_risk - 1) / (double)at_risk;
+			if(survival <= 0.5){
+				return obs[i].time;
+			}
+		}
+		at_risk--;
+	}
+	return -1;
+}
+
+/**
+ * Write the summary line "param km_median censored_count count" for one parameter, the median is inf
+ * when too many trials were censored for it to be estimated
+ * @param f     The file to write to
+ * @param param The parameter the observations belong to
+ * @param obs   The observations
+ * @param count The number of observations
+ */
+static inline void km_write_summary(FILE *f, double param, observation *obs, int count){
+	int censored = 0;
+	for(int i = 0; i < count; i++){
+		censored += obs[i].censored;
+	}
+	double median = km_median(obs, count);
+	if(median < 0){
+		fprintf(f, "%f inf %d %d\n", param, censored, count);
+	}
+	else{
+		fprintf(f, "%f %.0f %d %d\n", param, median, censored, count);
+	}
+}
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * Single long run relaxation estimator: instead of k coupling runs per parameter, run one chain
+ * (or a few, k) for a fixed number of steps, stream its observables once per sweep and report
+ * their integrated autocorrelation times, both from the FFT autocorrelation with automatic
+ * windowing and from online batch means (see autocorr.h). The first tenth of every run is burn in.
+ * Build from this directory with
+ * cc -std=gnu11 -O2 mcs-autocorr.c -o mcs-autocorr -lm
+ */
+#include <stdint.h>
+#include "models.h"
+
+void estimate(const model *m, int n, int k, double low, double high, double step,
+	unsigned long long steps, int store, trial *t);
+
+/**
+ * Main method wrapper
+ * @param  argc the number of arguments
+ * @param  argv the arguments array
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	//-b keeps only the batch means, in O(1) memory per observable
+	int store = 1;
+	if(argc > 1 && strcmp(argv[1], "-b") == 0){
+		store = 0;
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+	trial t = {0};
+	shard sh;
+	int a = shard_options(argc, argv, &t.seed, &sh);
+	const model *m = a < 0 || argc - a < 1 ? NULL : model_find(argv[a]);
+	int n = 0, k = 0;
+	double low = 0, high = 0, step = 0;
+	//signed so a negative count is rejected instead of wrapping
+	long long steps = 0;
+	if(m != NULL && argc - a >= 6){
+		n = atoi(argv[a + 1]);
+		low = atof(argv[a + 2]);
+		high = atof(argv[a + 3]);
+		step = atof(argv[a + 4]);
+		steps = strtoll(argv[a + 5], NULL, 10);
+		k = argc - a > 6 ? atoi(argv[a + 6]) : 1;
+	}
+	//steps 0 would mean no cap, and a relaxation run never ends on its own
+	if(m == NULL || m->relax == NULL || argc - a < 6 || argc - a > 7 || sh.count > 1 || n < 1 || k < 1 || steps < 1
+			|| step <= 0){
+		printf("Must supply [-b] [-s seed] model, n, low, high, step, steps and optionally k space delimited\n");
+		return 1;
+	}
+	estimate(m, n, k, low, high, step, steps, store, &t);
+	return 0;
+}
+
+/**
+ * Run k long chains per parameter and write "param k observable tau_fft window tau_batch samples mean"
+ * lines, the autocorrelation times in sweeps, nan where the run was too short to estimate them
+ * @param m     The model
+ * @param n     The size of the graph
+ * @param k     The number of runs for each parameter
+ * @param low   The parameter to start at
+ * @param high  The parameter to end at
+ * @param step  The increment for the parameter
+ * @param steps The length of every run in steps
+ * @param store Whether to keep the samples for the FFT estimator
+ * @param t     The trial, carrying the seed
+ */
+void estimate(const model *m, int n, int k, double low, double high, double step,
+		unsigned long long steps, int store, trial *t){
+	unsigned long long sites = m->torus ? (unsigned long long)n * n : (unsigned long long)n;
+	size_t burn_in = steps / sites / 10;
+	char file_name[200];
+	sprintf(file_name, "results/autocorr-%s:%d:%d:%f:%f:%f:%llu:%llu", m->prefix, n, k, low, high, step, steps,
+		(unsigned long long)t->seed);
+	FILE *f = fopen(file_name, "w");
+	if(NULL == f){
+		printf("Error opening results file");
+		exit(1);
+	}
+	char status_name[210];
+	sprintf(status_name, "%s.status", file_name);
+	status = status_open(status_name, m->name, n, k, low, high, step, sweep_tasks(k, low, high, step), 1);
+	pool scratch = {0};
+	t->scratch = &scratch;
+	t->max_steps = steps;
+	series obs[MAX_OBSERVABLES];
+	int task = 0;
+	int params = sweep_count(low, high, step);
+	for(int c = 0; c < params; c++){
+		double p = sweep_param(low, step, c);
+		for(int i = 0; i < k; i++, task++){
+			for(int o = 0; o < m->observables; o++){
+				series_init(&obs[o], store, burn_in);
+			}
+			status_begin_task(p, i);
+			trial_start(t, task, p, i);
+			unsigned long long iterations = m->relax(n, p, t, obs);
+			status_end_task(iterations);
+			for(int o = 0; o < m->observables; o++){
+				long window = -1;
+				double tau_fft = store ? series_tau_fft(&obs[o], &window) : NAN;
+				double tau_batch = series_tau_batch(&obs[o]);
+				fprintf(f, "%f %d %s %f %ld %f %llu %f\n", p, i, m->observable[o], tau_fft, window, tau_batch,
+					obs[o].count, obs[o].mean);
+				printf("%s: %f, k: %d, %s: tau_fft: %f (window %ld), tau_batch: %f sweeps over %llu samples\n",
+					m->param, p, i, m->observable[o], tau_fft, window, tau_batch, obs[o].count);
+				series_free(&obs[o]);
+			}
+		}
+	}
+	fclose(f);
+	pool_release(&scratch);
+	status_close(status);
+}
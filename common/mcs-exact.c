@@ -0,0 +1,653 @@
+/**
+ * Exact mixing quantities of the mean field chains from their lumped transition matrices, instead of
+ * Monte Carlo coupling. By symmetry the Curie-Weiss heat bath chain lumps to a birth death chain on the
+ * number of + spins (n + 1 states), and the Potts Glauber-Metropolis chain on K_n lumps to a chain on
+ * q = 3 type vectors ((n + 1)(n + 2) / 2 states). Starting from all vertexes equal, the distribution of
+ * the full chain is exchangeable, so its total variation distance to stationarity equals that of the
+ * lumped chain.
+ *
+ * For every parameter this reports the absolute spectral gap (Sturm bisection on the symmetrized
+ * tridiagonal matrix for Curie-Weiss, Lanczos for Potts), the relaxation time 1 / gap and the mixing
+ * time t_mix(eps) from the extremal start, found by repeated sparse matrix vector products. Only the
+ * band of states carrying probability mass is multiplied, mass below PRUNE is dropped and the total
+ * dropped mass is reported as the error bound on the distance. Parameters run in parallel.
+ * Build from this directory with
+ * cc -std=gnu11 -O2 -pthread mcs-exact.c -o mcs-exact -lm
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "rng.h"
+
+#define PRUNE 1e-30
+#define LANCZOS_MAX 3000
+#define LANCZOS_TOL 1e-13
+#define MAX_THREADS 64
+//the largest n whose lumped chain keeps its CSR indexes in int and fits in memory, (n + 1)(n + 2) / 2 Potts states
+//at n = 1000 already take 40 MB
+#define CURIE_WEISS_MAX_N 100000000
+#define POTTS_MAX_N 1000
+
+//sparse transition matrix P by rows (CSR) with its stationary distribution
+typedef struct chain{
+	int states;
+	int *row;
+	int *col;
+	double *p;
+	double *pi;
+	//start of the mixing time measurement
+	int start;
+} chain;
+
+typedef struct result{
+	double param;
+	double gap;
+	unsigned long long t_mix;
+	double tv_error;
+} result;
+
+static const char *model_name;
+static int n;
+static double eps = 0.25;
+static unsigned long long max_steps;
+static result *results;
+static int result_count;
+static int next_result = 0;
+static pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *worker(void *arg);
+
+/**
+ * Main method wrapper
+ * @param  argc the number of arguments
+ * @param  argv the arguments array
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int opt;
+	while((opt = getopt(argc, argv, "+j:e:m:")) != -1){
+		if(opt == 'j'){
+			threads = atoi(optarg);
+		}
+		else if(opt == 'e'){
+			eps = atof(optarg);
+		}
+		else if(opt == 'm'){
+			max_steps = strtoull(optarg, NULL, 10);
+		}
+		else{
+			argc = 0;
+		}
+	}
+	int a = optind;
+	if(argc - a != 5 || (strcmp(argv[a], "curie-weiss") != 0 && strcmp(argv[a], "potts-glauber-metropolis") != 0)){
+		printf("Must supply [-j threads] [-e eps] [-m max_steps] curie-weiss|potts-glauber-metropolis, n, low, high, step space delimited\n");
+		return 1;
+	}
+	model_name = argv[a];
+	long long size = strtoll(argv[a + 1], NULL, 10);
+	int max_n = strcmp(model_name, "curie-weiss") == 0 ? CURIE_WEISS_MAX_N : POTTS_MAX_N;
+	if(size < 1 || size > max_n){
+		printf("n must be between 1 and %d for %s\n", max_n, model_name);
+		return 1;
+	}
+	n = (int)size;
+	double low = atof(argv[a + 2]);
+	double high = atof(argv[a + 3]);
+	double step = atof(argv[a + 4]);
+	if(max_steps == 0){
+		max_steps = (unsigned long long)(100.0 * n * (log(n) + 1));
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+	if(threads > MAX_THREADS){
+		threads = MAX_THREADS;
+	}
+
+	//the parameters are computed from their index as the sweeps do (sweep.h), adding step up drifts
+	result_count = step <= 0 ? 1 : high < low ? 0 : (int)floor((high - low) / step + 1e-9) + 1;
+	results = calloc(result_count, sizeof(result));
+	int i;
+	for(i = 0; i < result_count; i++){
+		results[i].param = low + i * step;
+	}
+	pthread_t thread[MAX_THREADS];
+	for(i = 0; i < threads; i++){
+		pthread_create(&thread[i], NULL, worker, NULL);
+	}
+	for(i = 0; i < threads; i++){
+		pthread_join(thread[i], NULL);
+	}
+
+	char file_name[200];
+	sprintf(file_name, "results/exact-%s:%d:%f:%f:%f:%f", model_name, n, low, high, step, eps);
+	FILE *f = fopen(file_name, "w");
+	if(NULL == f){
+		printf("Error opening results file");
+		exit(1);
+	}
+	//param gap relaxation_time t_mix tv_error, t_mix is inf if the distance did not drop below eps in max_steps
+	for(i = 0; i < result_count; i++){
+		result *r = &results[i];
+		fprintf(f, "%f %.17g %.17g ", r->param, r->gap, 1 / r->gap);
+		if(r->t_mix > max_steps){
+			fprintf(f, "inf %g\n", r->tv_error);
+		}
+		else{
+			fprintf(f, "%llu %g\n", r->t_mix, r->tv_error);
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+/**
+ * Normalize log weights into a probability vector
+ * @param pi     The log weights in, the probabilities out
+ * @param states The number of states
+ */
+static void normalize_log(double *pi, int states){
+	double top = -INFINITY, total = 0;
+	for(int i = 0; i < states; i++){
+		top = fmax(top, pi[i]);
+	}
+	for(int i = 0; i < states; i++){
+		pi[i] = exp(pi[i] - top);
+		total += pi[i];
+	}
+	for(int i = 0; i < states; i++){
+		pi[i] /= total;
+	}
+}
+
+/**
+ * Probability the Curie-Weiss heat bath chain moves between + counts
+ * @param  m     The number of + spins
+ * @param  up    1 for m -> m + 1, 0 for m -> m - 1
+ * @param  alpha The alpha for the partition function
+ * @return       The transition probability
+ */
+static double curie_weiss_move(int m, int up, double alpha){
+	//the spin sum of the other vertexes when the chosen vertex is - (up) or + (down)
+	int spin_sum = up ? 2 * m - n + 1 : 2 * m - n - 1;
+	double pos_prob = 1 / (1 + exp(-2 * alpha / n * spin_sum));
+	return up ? (n - m) / (double)n * pos_prob : m / (double)n * (1 - pos_prob);
+}
+
+/**
+ * Build the lumped Curie-Weiss chain on the number of + spins, started at all +
+ * @param ch    The chain
+ * @param alpha The alpha for the partition function
+ */
+void build_curie_weiss(chain *ch, double alpha){
+	int states = n + 1;
+	ch->states = states;
+	ch->row = malloc((states + 1) * sizeof(int));
+	ch->col = malloc(3 * (size_t)states * sizeof(int));
+	ch->p = malloc(3 * (size_t)states * sizeof(double));
+	ch->pi = malloc(states * sizeof(double));
+	int e = 0;
+	for(int m = 0; m <= n; m++){
+		ch->row[m] = e;
+		double down = m > 0 ? curie_weiss_move(m, 0, alpha) : 0;
+		double up = m < n ? curie_weiss_move(m, 1, alpha) : 0;
+		if(m > 0){
+			ch->col[e] = m - 1;
+			ch->p[e++] = down;
+		}
+		ch->col[e] = m;
+		ch->p[e++] = 1 - down - up;
+		if(m < n){
+			ch->col[e] = m + 1;
+			ch->p[e++] = up;
+		}
+		//Gibbs weight exp(alpha / n sum_{i<j} s_i s_j) = exp(alpha / 2n (M^2 - n)) with M = 2m - n
+		double M = 2 * m - n;
+		ch->pi[m] = lgamma(n + 1) - lgamma(m + 1) - lgamma(n - m + 1) + alpha / (2.0 * n) * M * M;
+	}
+	ch->row[states] = e;
+	normalize_log(ch->pi, states);
+	ch->start = n;
+}
+
+/**
+ * Index of the type vector (a, b, n - a - b)
+ */
+static inline int potts_index(int a, int b){
+	return a * (n + 1) - a * (a - 1) / 2 + b;
+}
+
+/**
+ * Probability the Potts Glauber-Metropolis chain moves one vertex from spin class from to class to
+ * @param  type The type vector
+ * @param  from The old spin
+ * @param  to   The new spin, different from from
+ * @param  c    The c for the partition function
+ * @return      The transition probability
+ */
+static double potts_move(const int *type, int from, int to, double c){
+	double accept = fmin(1, exp(c / n * (type[to] - (type[from] - 1))));
+	return type[from] / (double)n / 3 * accept;
+}
+
+/**
+ * Build the lumped q = 3 Potts chain on type vectors, started at all 0
+ * @param ch The chain
+ * @param c  The c for the partition function
+ */
+void build_potts(chain *ch, double c){
+	int states = (n + 1) * (n + 2) / 2;
+	ch->states = states;
+	ch->row = malloc((states + 1) * sizeof(int));
+	ch->col = malloc(7 * (size_t)states * sizeof(int));
+	ch->p = malloc(7 * (size_t)states * sizeof(double));
+	ch->pi = malloc(states * sizeof(double));
+	int e = 0;
+	for(int a = 0; a <= n; a++){
+		for(int b = 0; a + b <= n; b++){
+			int i = potts_index(a, b);
+			int type[3] = {a, b, n - a - b};
+			ch->row[i] = e;
+			double stay = 1;
+			int diag = e++;
+			for(int from = 0; from < 3; from++){
+				for(int to = 0; to < 3; to++){
+					if(from == to || type[from] == 0){
+						continue;
+					}
+					int next[3] = {type[0], type[1], type[2]};
+					next[from]--;
+					next[to]++;
+					ch->col[e] = potts_index(next[0], next[1]);
+					ch->p[e] = potts_move(type, from, to, c);
+					stay -= ch->p[e++];
+				}
+			}
+			ch->col[diag] = i;
+			ch->p[diag] = stay;
+			//multinomial count times exp(c / n * number of agreeing pairs)
+			double pairs = 0, log_pi = lgamma(n + 1);
+			for(int s = 0; s < 3; s++){
+				pairs += type[s] * (type[s] - 1) / 2.0;
+				log_pi -= lgamma(type[s] + 1);
+			}
+			ch->pi[i] = log_pi + c / n * pairs;
+		}
+	}
+	ch->row[states] = e;
+	normalize_log(ch->pi, states);
+	ch->start = potts_index(n, 0);
+}
+
+/**
+ * Free a chain
+ * @param ch The chain
+ */
+void chain_free(chain *ch){
+	free(ch->row);
+	free(ch->col);
+	free(ch->p);
+	free(ch->pi);
+}
+
+/**
+ * Number of eigenvalues below x of the symmetric tridiagonal matrix (Sturm sequence)
+ * @param  diag The diagonal
+ * @param  off  The off diagonal, off[i] couples i and i + 1
+ * @param  len  The dimension
+ * @param  x    The shift
+ * @return      The count
+ */
+static int sturm_count(const double *diag, const double *off, int len, double x){
+	int count = 0;
+	double d = 1;
+	for(int i = 0; i < len; i++){
+		double o = i > 0 ? off[i - 1] : 0;
+		d = diag[i] - x - (i > 0 ? o * o / d : 0);
+		if(d == 0){
+			d = -1e-300;
+		}
+		if(d < 0){
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * The k-th smallest eigenvalue (from 0) of a symmetric tridiagonal matrix by bisection
+ * @param  diag The diagonal
+ * @param  off  The off diagonal
+ * @param  len  The dimension
+ * @param  k    Which eigenvalue
+ * @return      The eigenvalue
+ */
+static double tridiagonal_eigenvalue(const double *diag, const double *off, int len, int k){
+	double low = INFINITY, high = -INFINITY;
+	//Gershgorin bounds
+	for(int i = 0; i < len; i++){
+		double r = (i > 0 ? fabs(off[i - 1]) : 0) + (i < len - 1 ? fabs(off[i]) : 0);
+		low = fmin(low, diag[i] - r);
+		high = fmax(high, diag[i] + r);
+	}
+	for(int it = 0; it < 200 && high - low > 0; it++){
+		double mid = (low + high) / 2;
+		if(mid == low || mid == high){
+			break;
+		}
+		if(sturm_count(diag, off, len, mid) > k){
+			high = mid;
+		}
+		else{
+			low = mid;
+		}
+	}
+	return (low + high) / 2;
+}
+
+/**
+ * Entry P(i, j) of the chain, 0 if absent
+ */
+static double chain_entry(const chain *ch, int i, int j){
+	for(int e = ch->row[i]; e < ch->row[i + 1]; e++){
+		if(ch->col[e] == j){
+			return ch->p[e];
+		}
+	}
+	return 0;
+}
+
+/**
+ * Absolute spectral gap of a birth death chain, exact up to bisection: D^1/2 P D^-1/2 is the symmetric
+ * tridiagonal matrix with off diagonal sqrt(P(m, m + 1) P(m + 1, m))
+ * @param  ch The chain, states ordered along the birth death line
+ * @return    1 - max(lambda_2, -lambda_min)
+ */
+double birth_death_gap(const chain *ch){
+	int len = ch->states;
+	double *diag = malloc(len * sizeof(double));
+	double *off = malloc(len * sizeof(double));
+	for(int i = 0; i < len; i++){
+		diag[i] = chain_entry(ch, i, i);
+		off[i] = i < len - 1 ? sqrt(chain_entry(ch, i, i + 1) * chain_entry(ch, i + 1, i)) : 0;
+	}
+	double second = tridiagonal_eigenvalue(diag, off, len, len - 2);
+	double smallest = tridiagonal_eigenvalue(diag, off, len, 0);
+	free(diag);
+	free(off);
+	return 1 - fmax(second, -smallest);
+}
+
+/**
+ * Absolute spectral gap of a reversible chain by Lanczos on S = D^1/2 P D^-1/2, whose entries are
+ * sqrt(P(i, j) P(j, i)), with the top eigenvector sqrt(pi) projected out at every step so the extreme
+ * Ritz values converge to lambda_2 and lambda_min
+ * @param  ch   The chain
+ * @param  seed The seed of the start vector
+ * @return      1 - max(lambda_2, -lambda_min)
+ */
+double lanczos_gap(const chain *ch, uint64_t seed){
+	int len = ch->states;
+	double *s = malloc(ch->row[len] * sizeof(double));
+	for(int i = 0; i < len; i++){
+		for(int e = ch->row[i]; e < ch->row[i + 1]; e++){
+			s[e] = sqrt(ch->p[e] * chain_entry(ch, ch->col[e], i));
+		}
+	}
+	double *u = malloc(len * sizeof(double));
+	double *v = malloc(len * sizeof(double));
+	double *prev = calloc(len, sizeof(double));
+	double *w = malloc(len * sizeof(double));
+	double *alpha = calloc(LANCZOS_MAX, sizeof(double));
+	double *beta = calloc(LANCZOS_MAX, sizeof(double));
+	rng r;
+	rng_seed(&r, seed, 0);
+	double norm = 0, dot = 0;
+	for(int i = 0; i < len; i++){
+		u[i] = sqrt(ch->pi[i]);
+		v[i] = rng_double(&r) - 0.5;
+		dot += u[i] * v[i];
+	}
+	for(int i = 0; i < len; i++){
+		v[i] -= dot * u[i];
+		norm += v[i] * v[i];
+	}
+	norm = sqrt(norm);
+	for(int i = 0; i < len; i++){
+		v[i] /= norm;
+	}
+
+	double top = 0, bottom = 0, last_top = 2, last_bottom = 2;
+	int steps = 1;
+	for(int j = 0; j < LANCZOS_MAX && j < len - 1; j++){
+		for(int i = 0; i < len; i++){
+			double sum = 0;
+			for(int e = ch->row[i]; e < ch->row[i + 1]; e++){
+				sum += s[e] * v[ch->col[e]];
+			}
+			w[i] = sum;
+		}
+		dot = 0;
+		for(int i = 0; i < len; i++){
+			dot += u[i] * w[i];
+		}
+		double a = 0;
+		for(int i = 0; i < len; i++){
+			w[i] -= dot * u[i];
+			a += w[i] * v[i];
+		}
+		norm = 0;
+		for(int i = 0; i < len; i++){
+			w[i] -= a * v[i] + (j > 0 ? beta[j - 1] : 0) * prev[i];
+			norm += w[i] * w[i];
+		}
+		alpha[j] = a;
+		beta[j] = sqrt(norm);
+		steps = j + 1;
+		if(steps % 10 == 0 || beta[j] < 1e-14){
+			top = tridiagonal_eigenvalue(alpha, beta, steps, steps - 1);
+			bottom = tridiagonal_eigenvalue(alpha, beta, steps, 0);
+			if((fabs(top - last_top) < LANCZOS_TOL && fabs(bottom - last_bottom) < LANCZOS_TOL) || beta[j] < 1e-14){
+				break;
+			}
+			last_top = top;
+			last_bottom = bottom;
+		}
+		double *t = prev;
+		prev = v;
+		v = t;
+		for(int i = 0; i < len; i++){
+			v[i] = w[i] / beta[j];
+		}
+	}
+	top = tridiagonal_eigenvalue(alpha, beta, steps, steps - 1);
+	bottom = tridiagonal_eigenvalue(alpha, beta, steps, 0);
+	free(s);
+	free(u);
+	free(v);
+	free(prev);
+	free(w);
+	free(alpha);
+	free(beta);
+	return 1 - fmax(top, -bottom);
+}
+
+/**
+ * First time the distribution from ch->start is within eps of stationarity in total variation,
+ * multiplying only the band [low, high] of states that carry mass
+ * @param  ch    The chain
+ * @param  error Set to the mass dropped by pruning, a bound on the error of every distance computed
+ * @return       The mixing time, max_steps + 1 if not reached
+ */
+unsigned long long mixing_time(const chain *ch, double *error){
+	int len = ch->states;
+	double *mu = calloc(len, sizeof(double));
+	double *next = calloc(len, sizeof(double));
+	//prefix sums of pi give the stationary mass outside the band in O(1)
+	double *pi_prefix = malloc((len + 1) * sizeof(double));
+	pi_prefix[0] = 0;
+	for(int i = 0; i < len; i++){
+		pi_prefix[i + 1] = pi_prefix[i] + ch->pi[i];
+	}
+	int low = ch->start, high = ch->start;
+	mu[ch->start] = 1;
+	*error = 0;
+	unsigned long long t;
+	for(t = 0; t <= max_steps; t++){
+		double tv = pi_prefix[low] + (pi_prefix[len] - pi_prefix[high + 1]);
+		for(int i = low; i <= high; i++){
+			tv += fabs(mu[i] - ch->pi[i]);
+		}
+		if(tv / 2 <= eps){
+			break;
+		}
+		int new_low = len, new_high = -1;
+		for(int i = low; i <= high; i++){
+			if(mu[i] == 0){
+				continue;
+			}
+			for(int e = ch->row[i]; e < ch->row[i + 1]; e++){
+				int j = ch->col[e];
+				next[j] += mu[i] * ch->p[e];
+				new_low = j < new_low ? j : new_low;
+				new_high = j > new_high ? j : new_high;
+			}
+		}
+		for(int i = low; i <= high; i++){
+			mu[i] = 0;
+		}
+		//drop negligible mass at the ends of the band
+		while(new_low < new_high && next[new_low] < PRUNE){
+			*error += next[new_low];
+			next[new_low++] = 0;
+		}
+		while(new_high > new_low && next[new_high] < PRUNE){
+			*error += next[new_high];
+			next[new_high--] = 0;
+		}
+		double *swap = mu;
+		mu = next;
+		next = swap;
+		low = new_low;
+		high = new_high;
+	}
+	free(mu);
+	free(next);
+	free(pi_prefix);
+	return t;
+}
+
+/**
+ * mixing_time for a birth death chain. A step only moves mass to the neighboring states, so the product is
+ * three multiplies per state of the band with no index lookups, and the distance is summed in the same pass
+ * @param  ch    The chain, states ordered along the birth death line
+ * @param  error Set to the mass dropped by pruning, a bound on the error of every distance computed
+ * @return       The mixing time, max_steps + 1 if not reached
+ */
+unsigned long long birth_death_mixing_time(const chain *ch, double *error){
+	int len = ch->states;
+	//one padding state at each end keeps the band's neighbors in range
+	double *up = (double *)calloc(len + 2, sizeof(double)) + 1;
+	double *stay = (double *)calloc(len + 2, sizeof(double)) + 1;
+	double *down = (double *)calloc(len + 2, sizeof(double)) + 1;
+	double *mu = (double *)calloc(len + 2, sizeof(double)) + 1;
+	double *next = (double *)calloc(len + 2, sizeof(double)) + 1;
+	double *pi_prefix = malloc((len + 1) * sizeof(double));
+	pi_prefix[0] = 0;
+	for(int i = 0; i < len; i++){
+		pi_prefix[i + 1] = pi_prefix[i] + ch->pi[i];
+		stay[i] = chain_entry(ch, i, i);
+		up[i] = i < len - 1 ? chain_entry(ch, i, i + 1) : 0;
+		down[i] = i > 0 ? chain_entry(ch, i, i - 1) : 0;
+	}
+	const double *pi = ch->pi;
+	int low = ch->start, high = ch->start;
+	mu[ch->start] = 1;
+	*error = 0;
+	double tv = 1 - pi[ch->start] + fabs(1 - pi[ch->start]);
+	unsigned long long t;
+	for(t = 0; t <= max_steps && tv / 2 > eps; t++){
+		int new_low = low > 0 ? low - 1 : 0;
+		int new_high = high < len - 1 ? high + 1 : len - 1;
+		tv = pi_prefix[new_low] + (pi_prefix[len] - pi_prefix[new_high + 1]);
+		for(int i = new_low; i <= new_high; i++){
+			next[i] = mu[i - 1] * up[i - 1] + mu[i] * stay[i] + mu[i + 1] * down[i + 1];
+			tv += fabs(next[i] - pi[i]);
+		}
+		for(int i = low; i <= high; i++){
+			mu[i] = 0;
+		}
+		//drop negligible mass at the ends of the band, the distance then counts their pi mass as outside
+		while(new_low < new_high && next[new_low] < PRUNE){
+			*error += next[new_low];
+			tv += pi[new_low] - fabs(next[new_low] - pi[new_low]);
+			next[new_low++] = 0;
+		}
+		while(new_high > new_low && next[new_high] < PRUNE){
+			*error += next[new_high];
+			tv += pi[new_high] - fabs(next[new_high] - pi[new_high]);
+			next[new_high--] = 0;
+		}
+		double *swap = mu;
+		mu = next;
+		next = swap;
+		low = new_low;
+		high = new_high;
+	}
+	free(up - 1);
+	free(stay - 1);
+	free(down - 1);
+	free(mu - 1);
+	free(next - 1);
+	free(pi_prefix);
+	return t;
+}
+
+/**
+ * Worker thread, solves parameters until none are left
+ * @param  arg not used
+ * @return     not used
+ */
+void *worker(void *arg){
+	(void)arg;
+	while(1){
+		pthread_mutex_lock(&next_lock);
+		int i = next_result++;
+		pthread_mutex_unlock(&next_lock);
+		if(i >= result_count){
+			break;
+		}
+		result *r = &results[i];
+		chain ch;
+		if(strcmp(model_name, "curie-weiss") == 0){
+			build_curie_weiss(&ch, r->param);
+			r->gap = birth_death_gap(&ch);
+		}
+		else{
+			build_potts(&ch, r->param);
+			r->gap = lanczos_gap(&ch, i);
+		}
+		//t_mix >= (t_rel - 1) log(1 / 2eps) for reversible chains, skip the product when that is past the cap
+		if((1 / r->gap - 1) * log(1 / (2 * eps)) > max_steps){
+			r->t_mix = max_steps + 1;
+			r->tv_error = 0;
+		}
+		else{
+			r->t_mix = strcmp(model_name, "curie-weiss") == 0 ? birth_death_mixing_time(&ch, &r->tv_error) : mixing_time(&ch, &r->tv_error);
+		}
+		chain_free(&ch);
+		//inf like the results file when the distance did not drop below eps in max_steps
+		char t_mix[32] = "inf";
+		if(r->t_mix <= max_steps){
+			sprintf(t_mix, "%llu", r->t_mix);
+		}
+		printf("%s n: %d, param: %f, gap: %g, relaxation time: %g, t_mix(%g): %s\n", model_name, n, r->param, r->gap,
+			1 / r->gap, eps, t_mix);
+	}
+	return NULL;
+}
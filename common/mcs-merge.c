@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "censor.h"
+
+typedef struct row{
+	char *line;
+	double param;
+	unsigned long long iterations;
+	int censored;
+} row;
+
+int read_shard(const char *path, row **rows, int *tasks, int *k, int *count, const char ***seen);
+int merge_samples(const char *file_name, const char **seen, int count);
+int is_shard_name(const char *path);
+
+/**
+ * Merge the shard files of a sweep (see shard.h) into the results and .km files a single process run
+ * with the same seed writes, and the .samples files of a -C sweep into one in task order. Build with cc -std=gnu11 -O2 mcs-merge.c -o mcs-merge
+ * @param  argc the number of arguments
+ * @param  argv all the shard files of one sweep, in any order; the shards' status pages a glob also
+ *              picks up are skipped
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	if(argc < 2){
+		printf("Must supply the shard files of a sweep\n");
+		return 1;
+	}
+	row *rows = NULL;
+	int tasks = -1, k = -1, count = -1, shards = 0, first = 0;
+	const char **seen = NULL;
+	for(int i = 1; i < argc; i++){
+		if(!is_shard_name(argv[i])){
+			continue;
+		}
+		if(!read_shard(argv[i], &rows, &tasks, &k, &count, &seen)){
+			return 1;
+		}
+		if(shards++ == 0){
+			first = i;
+		}
+	}
+	if(shards == 0 || count != shards){
+		printf("Expected %d shard files, got %d\n", count < 0 ? 1 : count, shards);
+		return 1;
+	}
+	for(int task = 0; task < tasks; task++){
+		if(rows[task].line == NULL){
+			printf("Task %d is missing from the shards\n", task);
+			return 1;
+		}
+	}
+
+	//the merged file is named like the shards without the shard suffix
+	char file_name[1024];
+	snprintf(file_name, sizeof(file_name), "%s", argv[first]);
+	char *suffix = strstr(file_name, ":shard-");
+	if(suffix != NULL){
+		*suffix = '\0';
+	}
+	char km_name[1040];
+	sprintf(km_name, "%s.km", file_name);
+	FILE *f = fopen(file_name, "w");
+	FILE *km = fopen(km_name, "w");
+	if(NULL == f || NULL == km){
+		printf("Error opening results file %s\n", file_name);
+		return 1;
+	}
+	observation *obs = malloc(k * sizeof(observation));
+	for(int task = 0; task < tasks; task++){
+		fputs(rows[task].line, f);
+		obs[task % k].time = rows[task].iterations;
+		obs[task % k].censored = rows[task].censored;
+		if(task % k == k - 1){
+			km_write_summary(km, rows[task].param, obs, k);
+		}
+	}
+	fclose(f);
+	fclose(km);
+	if(!merge_samples(file_name, seen, count)){
+		return 1;
+	}
+	printf("merged %d tasks into %s\n", tasks, file_name);
+	return 0;
+}
+
+/**
+ * Concatenate the shards' .samples files, if the sweep wrote them, into file_name.samples. A shard runs
+ * one contiguous block of tasks in order, so shard index order is task order
+ * @param  file_name The merged results file
+ * @param  seen      The shard file of every shard index
+ * @param  count     The number of shards
+ * @return           1 on success or when there are no samples, 0 after printing the error
+ */
+int merge_samples(const char *file_name, const char **seen, int count){
+	char name[1040];
+	sprintf(name, "%s.samples", seen[0]);
+	FILE *in = fopen(name, "r");
+	if(NULL == in){
+		return 1;
+	}
+	sprintf(name, "%s.samples", file_name);
+	FILE *out = fopen(name, "w");
+	if(NULL == out){
+		printf("Error opening samples file %s\n", name);
+		return 0;
+	}
+	char buf[256];
+	for(int i = 0; i < count; i++){
+		if(i > 0){
+			sprintf(name, "%s.samples", seen[i]);
+			in = fopen(name, "r");
+			if(NULL == in){
+				printf("Error opening samples of shard %s\n", seen[i]);
+				fclose(out);
+				return 0;
+			}
+		}
+		while(fgets(buf, sizeof(buf), in) != NULL){
+			fputs(buf, out);
+		}
+		fclose(in);
+	}
+	fclose(out);
+	return 1;
+}
+
+/**
+ * Whether a file is named like a shard, ending in the :shard-i-of-N suffix of shard_file_name, rather than
+ * a shard's status page next to it
+ * @param  path The file
+ * @return      1 for a shard name
+ */
+int is_shard_name(const char *path){
+	const char *suffix = strstr(path, ":shard-");
+	int index, count, end = 0;
+	return suffix != NULL && sscanf(suffix, ":shard-%d-of-%d%n", &index, &count, &end) == 2 && suffix[end] == '\0';
+}
+
+/**
+ * Read one shard file into rows, checking it belongs to the same sweep as the shards before it
+ * @param  path  The shard file
+ * @param  rows  The rows by task index, allocated on the first shard
+ * @param  tasks The number of tasks in the sweep, -1 before the first shard
+ * @param  k     The number of trials for each parameter
+ * @param  count The number of shards
+ * @param  seen  The shard file read for every shard index, NULL if none yet, count entries allocated on the
+ *               first shard
+ * @return       1 on success, 0 after printing the error
+ */
+int read_shard(const char *path, row **rows, int *tasks, int *k, int *count, const char ***seen){
+	FILE *f = fopen(path, "r");
+	if(NULL == f){
+		printf("Error opening shard %s\n", path);
+		return 0;
+	}
+	int index, shard_count, shard_tasks, shard_k;
+	if(fscanf(f, "#shard %d %d %d %d\n", &index, &shard_count, &shard_tasks, &shard_k) != 4){
+		printf("%s is not a shard file\n", path);
+		fclose(f);
+		return 0;
+	}
+	if(shard_count < 1 || shard_tasks < 0 || shard_k < 1){
+		printf("%s has a bad shard header\n", path);
+		fclose(f);
+		return 0;
+	}
+	if(*tasks < 0){
+		*seen = calloc(shard_count, sizeof(char *));
+		*tasks = shard_tasks;
+		*k = shard_k;
+		*count = shard_count;
+		*rows = calloc(shard_tasks, sizeof(row));
+	}
+	if(shard_tasks != *tasks || shard_k != *k || shard_count != *count){
+		printf("%s belongs to a different sweep\n", path);
+		fclose(f);
+		return 0;
+	}
+	if(index < 0 || index >= shard_count){
+		printf("%s has shard %d of %d\n", path, index, shard_count);
+		fclose(f);
+		return 0;
+	}
+	if((*seen)[index] != NULL){
+		printf("%s repeats shard %d\n", path, index);
+		fclose(f);
+		return 0;
+	}
+	(*seen)[index] = path;
+	char buf[256];
+	while(fgets(buf, sizeof(buf), f) != NULL){
+		int task, offset;
+		if(sscanf(buf, "%d %n", &task, &offset) != 1 || task < 0 || task >= *tasks || (*rows)[task].line != NULL){
+			printf("%s: bad or repeated task line %s", path, buf);
+			fclose(f);
+			return 0;
+		}
+		row *r = &(*rows)[task];
+		r->line = strdup(buf + offset);
+		char word[16] = "";
+		sscanf(r->line, "%lf %llu %15s", &r->param, &r->iterations, word);
+		r->censored = strcmp(word, "censored") == 0;
+	}
+	fclose(f);
+	return 1;
+}
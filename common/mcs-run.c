@@ -0,0 +1,332 @@
+/**
+ * Batch runner: executes every sweep listed in a manifest in one process on one pool of worker
+ * threads, so hundreds of small sweeps do not each pay for process startup, allocation and idle
+ * cores at the tail of a sweep. Each worker keeps one scratch pool for its whole life, so lattices
+ * and lists are reused across trials and across jobs. Build from this directory with
+ * cc -std=gnu11 -O2 -pthread mcs-run.c -o mcs-run -lm
+ *
+ * The manifest is a small TOML subset, one [[job]] table per sweep:
+ *
+ *   threads = 8            # optional, defaults to the number of cores
+ *
+ *   [[job]]
+ *   model = "torus"        # torus, curie-weiss, curie-weiss-totals, hardcore, potts-glauber-metropolis, swendsen-wang,
+ *                          # potts-torus-q3
+ *   n = 64
+ *   k = 5
+ *   low = 0.40
+ *   high = 0.45
+ *   step = 0.01
+ *   max_steps = 0          # optional budget, see trial.h
+ *   max_seconds = 0
+ *   seed = 1414025611      # optional, defaults to the current time
+ *
+ * Every job writes results/<prefix>:<n>:<k>:<low>:<high>:<step>:<seed>:<job index> and its .km file. The
+ * trials are the ones the standalone program runs with the same seed, but the names differ from its
+ * results files: the model prefix is used for every model, and the job index keeps two jobs with the same
+ * sweep and seed apart.
+ */
+#include <stdint.h>
+#include <ctype.h>
+#include <pthread.h>
+#include "models.h"
+#include "cache.h"
+
+#define MAX_JOBS 4096
+#define MAX_THREADS STATUS_MAX_WORKERS
+
+typedef struct job{
+	const model *m;
+	int n;
+	int k;
+	double low;
+	double high;
+	double step;
+	unsigned long long max_steps;
+	double max_seconds;
+	uint64_t seed;
+	int first_task;
+	int task_count;
+	atomic_int remaining;
+	cache trials;
+} job;
+
+typedef struct task{
+	int job;
+	double param;
+	int index;
+	unsigned long long iterations;
+	trial outcome;
+} task;
+
+static job jobs[MAX_JOBS];
+static int job_count = 0;
+static task *tasks = NULL;
+static int task_count = 0;
+static atomic_int next_task = 0;
+
+int read_manifest(const char *path, int *threads);
+void *worker(void *arg);
+void write_job(int j);
+
+/**
+ * Main method wrapper
+ * @param  argc the number of arguments
+ * @param  argv the manifest path
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	if(argc != 2){
+		printf("Must supply the manifest file\n");
+		return 1;
+	}
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(!read_manifest(argv[1], &threads)){
+		return 1;
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+	if(threads > MAX_THREADS){
+		threads = MAX_THREADS;
+	}
+
+	//flatten the jobs into (job, parameter, trial) tasks, stepping the parameter as the standalone sweeps do
+	for(int j = 0; j < job_count; j++){
+		task_count += sweep_tasks(jobs[j].k, jobs[j].low, jobs[j].high, jobs[j].step);
+	}
+	tasks = malloc(task_count * sizeof(task));
+	int next = 0;
+	for(int j = 0; j < job_count; j++){
+		jobs[j].first_task = next;
+		int params = sweep_count(jobs[j].low, jobs[j].high, jobs[j].step);
+		for(int p = 0; p < params; p++){
+			for(int i = 0; i < jobs[j].k; i++){
+				tasks[next].job = j;
+				tasks[next].param = sweep_param(jobs[j].low, jobs[j].step, p);
+				tasks[next].index = i;
+				next++;
+			}
+		}
+		jobs[j].task_count = next - jobs[j].first_task;
+		atomic_store(&jobs[j].remaining, jobs[j].task_count);
+		cache_open(&jobs[j].trials, jobs[j].m->name, *jobs[j].m->version, jobs[j].n, jobs[j].seed);
+	}
+
+	char status_name[1100];
+	snprintf(status_name, sizeof(status_name), "%s.status", argv[1]);
+	//a batch has no single sweep, so the page shows only the job count and the tasks of all jobs
+	char label[32];
+	snprintf(label, sizeof(label), "batch of %d jobs", job_count);
+	status = status_open(status_name, label, 0, 0, 0, 0, 0, task_count, threads);
+	printf("running %d jobs, %d tasks on %d threads\n", job_count, task_count, threads);
+
+	pthread_t thread[MAX_THREADS];
+	for(int i = 0; i < threads; i++){
+		pthread_create(&thread[i], NULL, worker, (void *)(intptr_t)i);
+	}
+	for(int i = 0; i < threads; i++){
+		pthread_join(thread[i], NULL);
+	}
+	status_close(status);
+	free(tasks);
+	return 0;
+}
+
+/**
+ * Worker thread, takes the next task until none are left. The last worker to finish a job writes its files.
+ * @param  arg The worker index
+ * @return     not used
+ */
+void *worker(void *arg){
+	status_worker_id = (int)(intptr_t)arg;
+	pool scratch = {0};
+	trial t = {0};
+	t.scratch = &scratch;
+	int i;
+	while((i = atomic_fetch_add(&next_task, 1)) < task_count){
+		task *tk = &tasks[i];
+		job *j = &jobs[tk->job];
+		t.max_steps = j->max_steps;
+		t.max_seconds = j->max_seconds;
+		t.seed = j->seed;
+		status_begin_task(tk->param, tk->index);
+		trial_start(&t, i - j->first_task, tk->param, tk->index);
+		//trials an overlapping sweep already ran come from the cache
+		if(!cache_lookup(&j->trials, tk->param, tk->index, &t, &tk->iterations)){
+			tk->iterations = j->m->mix(j->n, tk->param, &t);
+			cache_store(&j->trials, tk->param, tk->index, &t, tk->iterations);
+		}
+		status_end_task(tk->iterations);
+		tk->outcome = t;
+		if(t.censored){
+			printf("%s n: %d, %s: %f, k: %d, censored at iterations: %llu, disagreement: %lld\n", j->m->name, j->n,
+				j->m->param, tk->param, tk->index, tk->iterations, t.last_disagreement);
+		}
+		else{
+			printf("%s n: %d, %s: %f, k: %d, iterations: %llu\n", j->m->name, j->n, j->m->param, tk->param,
+				tk->index, tk->iterations);
+		}
+		if(atomic_fetch_sub(&j->remaining, 1) == 1){
+			write_job(tk->job);
+		}
+	}
+	pool_release(&scratch);
+	return NULL;
+}
+
+/**
+ * Write the results and Kaplan-Meier summary of a finished job
+ * @param j The job index
+ */
+void write_job(int j){
+	job *jb = &jobs[j];
+	char file_name[200];
+	sprintf(file_name, "results/%s:%d:%d:%f:%f:%f:%llu:%d", jb->m->prefix, jb->n, jb->k, jb->low, jb->high, jb->step,
+		(unsigned long long)jb->seed, j);
+	char km_name[210];
+	sprintf(km_name, "%s.km", file_name);
+	FILE *f = fopen(file_name, "w");
+	FILE *km = fopen(km_name, "w");
+	if(NULL == f || NULL == km){
+		printf("Error opening results file %s\n", file_name);
+		exit(1);
+	}
+	observation *obs = malloc(jb->k * sizeof(observation));
+	//tasks of a job are laid out parameter by parameter, k trials each
+	for(int i = 0; i < jb->task_count; i++){
+		task *tk = &tasks[jb->first_task + i];
+		trial_write(f, tk->param, tk->iterations, &tk->outcome);
+		obs[tk->index].time = tk->iterations;
+		obs[tk->index].censored = tk->outcome.censored;
+		if(tk->index == jb->k - 1){
+			km_write_summary(km, tk->param, obs, jb->k);
+		}
+	}
+	free(obs);
+	fclose(f);
+	fclose(km);
+	printf("job %d done: %s (%llu cached trials)\n", j, file_name, (unsigned long long)jb->trials.hits);
+}
+
+/**
+ * Strip leading and trailing white space in place
+ * @param  s The string
+ * @return   The trimmed string
+ */
+static char *trim(char *s){
+	while(isspace((unsigned char)*s)){
+		s++;
+	}
+	char *end = s + strlen(s);
+	while(end > s && isspace((unsigned char)end[-1])){
+		end--;
+	}
+	*end = '\0';
+	return s;
+}
+
+/**
+ * Read the manifest into jobs
+ * @param  path    The manifest file
+ * @param  threads Set if the manifest asks for a thread count
+ * @return         1 on success, 0 after printing the error
+ */
+int read_manifest(const char *path, int *threads){
+	FILE *f = fopen(path, "r");
+	if(NULL == f){
+		printf("Error opening manifest %s\n", path);
+		return 0;
+	}
+	char buf[512];
+	int line = 0;
+	job *jb = NULL;
+	while(fgets(buf, sizeof(buf), f) != NULL){
+		line++;
+		char *hash = strchr(buf, '#');
+		if(hash != NULL){
+			*hash = '\0';
+		}
+		char *s = trim(buf);
+		if(*s == '\0'){
+			continue;
+		}
+		if(strcmp(s, "[[job]]") == 0){
+			if(job_count == MAX_JOBS){
+				printf("%s:%d: more than %d jobs\n", path, line, MAX_JOBS);
+				fclose(f);
+				return 0;
+			}
+			jb = &jobs[job_count++];
+			memset(jb, 0, sizeof(job));
+			jb->k = 1;
+			jb->step = 1;
+			jb->seed = (uint64_t)time(NULL);
+			continue;
+		}
+		char *eq = strchr(s, '=');
+		if(eq == NULL){
+			printf("%s:%d: expected key = value\n", path, line);
+			fclose(f);
+			return 0;
+		}
+		*eq = '\0';
+		char *key = trim(s);
+		char *value = trim(eq + 1);
+		if(*value == '"'){
+			value++;
+			char *close = strchr(value, '"');
+			if(close != NULL){
+				*close = '\0';
+			}
+		}
+		if(jb == NULL && strcmp(key, "threads") == 0){
+			*threads = atoi(value);
+		}
+		else if(jb != NULL && strcmp(key, "model") == 0){
+			jb->m = model_find(value);
+			if(jb->m == NULL){
+				printf("%s:%d: unknown model %s\n", path, line, value);
+				fclose(f);
+				return 0;
+			}
+		}
+		else if(jb != NULL && strcmp(key, "n") == 0){
+			jb->n = atoi(value);
+		}
+		else if(jb != NULL && strcmp(key, "k") == 0){
+			jb->k = atoi(value);
+		}
+		else if(jb != NULL && strcmp(key, "low") == 0){
+			jb->low = atof(value);
+		}
+		else if(jb != NULL && strcmp(key, "high") == 0){
+			jb->high = atof(value);
+		}
+		else if(jb != NULL && strcmp(key, "step") == 0){
+			jb->step = atof(value);
+		}
+		else if(jb != NULL && strcmp(key, "max_steps") == 0){
+			jb->max_steps = strtoull(value, NULL, 10);
+		}
+		else if(jb != NULL && strcmp(key, "max_seconds") == 0){
+			jb->max_seconds = atof(value);
+		}
+		else if(jb != NULL && strcmp(key, "seed") == 0){
+			jb->seed = strtoull(value, NULL, 10);
+		}
+		else{
+			printf("%s:%d: unexpected key %s\n", path, line, key);
+			fclose(f);
+			return 0;
+		}
+	}
+	fclose(f);
+	for(int j = 0; j < job_count; j++){
+		if(jobs[j].m == NULL || jobs[j].n <= 0 || jobs[j].k <= 0 || jobs[j].step <= 0){
+			printf("%s: job %d needs a model and positive n, k and step\n", path, j);
+			return 0;
+		}
+	}
+	return 1;
+}
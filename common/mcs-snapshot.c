@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+
+int write_image(const unsigned char *data, size_t size, const snapshot_entry *entry, const snapshot_header *header, const char *path);
+
+/**
+ * Read a lattice snapshot stream (see snapshot.h). With only the stream it lists the snapshots as
+ * "index task iterations disagreement bytes", with an index and an output path it writes that snapshot
+ * as a PPM image: X up white, X down black, sites where X and Y disagree red.
+ * Build with cc -std=gnu11 -O2 -pthread mcs-snapshot.c -o mcs-snapshot
+ * @param  argc the number of arguments
+ * @param  argv the .snap file, optionally a snapshot index and an image path
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	if(argc != 2 && argc != 4){
+		printf("Must supply a .snap file and optionally a snapshot index and an output .ppm\n");
+		return 1;
+	}
+	int fd = open(argv[1], O_RDONLY);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header)){
+		printf("Error opening snapshot file %s\n", argv[1]);
+		return 1;
+	}
+	size_t size = st.st_size;
+	unsigned char *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if(data == MAP_FAILED){
+		printf("Error mapping snapshot file %s\n", argv[1]);
+		return 1;
+	}
+	snapshot_header header;
+	memcpy(&header, data, sizeof(header));
+	if(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0){
+		printf("%s is not a snapshot file\n", argv[1]);
+		return 1;
+	}
+
+	char index_name[strlen(argv[1]) + 5];
+	sprintf(index_name, "%s.idx", argv[1]);
+	FILE *index = fopen(index_name, "rb");
+	if(NULL == index){
+		printf("Error opening snapshot index %s\n", index_name);
+		return 1;
+	}
+	snapshot_entry entry;
+	long wanted = argc == 4 ? atol(argv[2]) : -1;
+	for(long i = 0; fread(&entry, sizeof(entry), 1, index) == 1; i++){
+		if(entry.offset + entry.bytes > size){
+			printf("Snapshot %ld is past the end of the stream\n", i);
+			return 1;
+		}
+		if(wanted < 0){
+			snapshot_record rec;
+			memcpy(&rec, data + entry.offset, sizeof(rec));
+			printf("%ld %d %llu %lld %u\n", i, rec.task, (unsigned long long)rec.iterations, (long long)rec.disagreement, entry.bytes);
+		}
+		else if(i == wanted){
+			fclose(index);
+			return !write_image(data, size, &entry, &header, argv[3]);
+		}
+	}
+	fclose(index);
+	if(wanted >= 0){
+		printf("No snapshot %ld\n", wanted);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Decode one snapshot and write it as a PPM image
+ * @param  data   The mapped stream
+ * @param  size   The size of the stream
+ * @param  entry  The index entry of the snapshot
+ * @param  header The stream header
+ * @param  path   The image path
+ * @return        1 on success, 0 after printing the error
+ */
+int write_image(const unsigned char *data, size_t size, const snapshot_entry *entry, const snapshot_header *header, const char *path){
+	snapshot_record rec;
+	memcpy(&rec, data + entry->offset, sizeof(rec));
+	size_t words = (header->sites + 63) / 64;
+	uint64_t *mask[3];
+	size_t offset = entry->offset + sizeof(rec);
+	for(int m = 0; m < 3; m++){
+		mask[m] = malloc(words * sizeof(uint64_t));
+		if(offset + rec.length[m] > size
+				|| !snapshot_decode(data + offset, rec.length[m], rec.encoding[m], header->sites, mask[m])){
+			printf("Snapshot mask %d is corrupt\n", m);
+			return 0;
+		}
+		offset += rec.length[m];
+	}
+	FILE *f = fopen(path, "wb");
+	if(NULL == f){
+		printf("Error opening image %s\n", path);
+		return 0;
+	}
+	fprintf(f, "P6\n%u %u\n255\n", header->side, header->side);
+	for(size_t i = 0; i < header->sites; i++){
+		int x = mask[0][i >> 6] >> (i & 63) & 1;
+		int diff = mask[2][i >> 6] >> (i & 63) & 1;
+		unsigned char pixel[3] = {x || diff ? 255 : 0, x && !diff ? 255 : 0, x && !diff ? 255 : 0};
+		fwrite(pixel, 1, 3, f);
+	}
+	fclose(f);
+	for(int m = 0; m < 3; m++){
+		free(mask[m]);
+	}
+	return 1;
+}
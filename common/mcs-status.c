@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <errno.h>
+#include "status.h"
+
+//a worker that has not published for this long is reported as stalled
+#define STALL_SECONDS 60.0
+
+void print_status(const status_page *page);
+
+/**
+ * Query the live status page of a running sweep. Build with
+ * cc -std=gnu11 -O2 mcs-status.c -o mcs-status
+ * @param  argc the number of arguments
+ * @param  argv the status file and optionally a refresh interval in seconds
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	if(argc < 2){
+		printf("Must supply the status file and optionally a refresh interval\n");
+		return 1;
+	}
+	int interval = argc > 2 ? atoi(argv[2]) : 0;
+	int fd = open(argv[1], O_RDONLY);
+	if(fd < 0){
+		printf("Error opening status file %s\n", argv[1]);
+		return 1;
+	}
+	status_page *page = mmap(NULL, sizeof(status_page), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(page == MAP_FAILED || page->magic != STATUS_MAGIC){
+		printf("%s is not a status page\n", argv[1]);
+		return 1;
+	}
+	while(1){
+		print_status(page);
+		if(interval <= 0){
+			break;
+		}
+		sleep(interval);
+		printf("\n");
+	}
+	munmap(page, sizeof(status_page));
+	return 0;
+}
+
+/**
+ * Print the sweep summary and one line per active worker
+ * @param page The mapped status page
+ */
+void print_status(const status_page *page){
+	double now = status_now();
+	double elapsed = now - page->started;
+	int done = atomic_load((atomic_int *)&page->tasks_done);
+	int total = atomic_load((atomic_int *)&page->tasks_total);
+	int alive = kill(page->pid, 0) == 0 || errno == EPERM;
+
+	printf("%s n: %lld, k: %d, range: %f..%f step %f, pid %d%s\n", page->model, page->n, page->k,
+		page->p_low, page->p_high, page->p_step, page->pid, alive ? "" : " (exited)");
+	printf("tasks: %d/%d, elapsed: %.0fs", done, total, elapsed);
+	if(done > 0 && done < total){
+		printf(", eta: %.0fs", elapsed / done * (total - done));
+	}
+	printf("\n");
+
+	status_worker w;
+	for(int i = 0; i < page->workers; i++){
+		status_snapshot(&page->worker[i], &w);
+		if(!w.active){
+			continue;
+		}
+		printf("  worker %d: param: %f, trial: %d, iterations: %llu, disagreement: %lld, steps/s: %.3g, task time: %.0fs%s\n",
+			i, w.param, w.trial, w.iterations, w.disagreement, w.steps_per_sec, now - w.task_started,
+			alive && now - w.updated > STALL_SECONDS ? " STALLED" : "");
+	}
+}
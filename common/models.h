@@ -0,0 +1,105 @@
+#ifndef MODELS_H
+#define MODELS_H
+
+/**
+ * Every model compiled into one program, for the tools that run several models in one process. Each
+ * model file is included with RUNNER defined, which leaves out its main, and with its kernels, engine
+ * version and model entry (see sweep.h) renamed so they do not clash; models lists the entries.
+ */
+#define RUNNER
+
+#define mix_chains torus_mix_chains
+#define mix_chains_counts torus_mix_chains_counts
+#define mix_chains_parallel torus_mix_chains_parallel
+#define relax_chain torus_relax_chain
+#define engine_version torus_engine_version
+#define model_entry torus_model
+#include "../ising-c-1.0/torus-glauber-heat-bath.c"
+#undef mix_chains
+#undef mix_chains_counts
+#undef mix_chains_parallel
+#undef relax_chain
+#undef engine_version
+#undef model_entry
+#define mix_chains curie_weiss_mix_chains
+#define relax_chain curie_weiss_relax_chain
+#define leap_chains curie_weiss_leap_chains
+#define engine_version curie_weiss_engine_version
+#define model_entry curie_weiss_model
+#include "../ising-c-1.0/curie_weiss-glauber-heat-bath.c"
+#undef mix_chains
+#undef relax_chain
+#undef leap_chains
+#undef engine_version
+#undef model_entry
+#define mix_chains curie_weiss_totals_mix_chains
+#define relax_chain curie_weiss_totals_relax_chain
+#define engine_version curie_weiss_totals_engine_version
+#define model_entry curie_weiss_totals_model
+#include "../ising-c-1.0/curie_weiss-glauber-heat-bath2.c"
+#undef mix_chains
+#undef relax_chain
+#undef engine_version
+#undef model_entry
+#define mix_chains hardcore_mix_chains
+#define relax_chain hardcore_relax_chain
+#define engine_version hardcore_engine_version
+#define model_entry hardcore_model
+#include "../hardcore_gas-model-simulation-c-1.0/independent_set_glauber.c"
+#undef mix_chains
+#undef relax_chain
+#undef engine_version
+#undef model_entry
+#define mix_chains potts_mix_chains
+#define relax_chain potts_relax_chain
+#define cftp_chains potts_cftp_chains
+#define engine_version potts_engine_version
+#define model_entry potts_model
+#include "../potts-c-1.0/glauber-metropolis.c"
+#undef mix_chains
+#undef relax_chain
+#undef cftp_chains
+#undef engine_version
+#undef model_entry
+#define mix_chains swendsen_wang_mix_chains
+#define engine_version swendsen_wang_engine_version
+#define model_entry swendsen_wang_model
+#include "../potts-c-1.0/swendsen-wang-c-1.0.c"
+#undef mix_chains
+#undef engine_version
+#undef model_entry
+#define mix_chains potts_torus_mix_chains
+#define cftp_chains potts_torus_cftp_chains
+#define engine_version potts_torus_engine_version
+#define model_entry potts_torus_model
+#include "../potts-c-1.0/torus-glauber-metropolis.c"
+#undef mix_chains
+#undef cftp_chains
+#undef engine_version
+#undef model_entry
+
+static const model *const models[] = {
+	&torus_model,
+	&curie_weiss_model,
+	&curie_weiss_totals_model,
+	&hardcore_model,
+	&potts_model,
+	&swendsen_wang_model,
+	&potts_torus_model,
+};
+
+/**
+ * Look a model up by name
+ * @param  name The model name
+ * @return      The model or NULL
+ */
+static inline const model *model_find(const char *name){
+	for(size_t i = 0; i < sizeof(models) / sizeof(models[0]); i++){
+		if(strcmp(name, models[i]->name) == 0){
+			return models[i];
+		}
+	}
+	return NULL;
+}
+
+#endif
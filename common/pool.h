@@ -0,0 +1,52 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Scratch buffers that outlive a single trial. mix_chains asks for its lattices and lists by slot
+ * number and gets the same memory back on every trial, a buffer is only reallocated when a later
+ * trial needs more than it holds. One pool belongs to one worker so no locking is needed.
+ */
+
+#define POOL_SLOTS 8
+
+typedef struct pool{
+	void *block[POOL_SLOTS];
+	size_t size[POOL_SLOTS];
+} pool;
+
+/**
+ * Get the buffer in the given slot with room for at least bytes, contents are unspecified
+ * @param  p     The pool
+ * @param  slot  The slot, fixed per use within a kernel
+ * @param  bytes The size needed
+ * @return       The buffer
+ */
+static inline void *pool_get(pool *p, int slot, size_t bytes){
+	if(p->size[slot] < bytes){
+		free(p->block[slot]);
+		p->block[slot] = malloc(bytes);
+		if(NULL == p->block[slot]){
+			printf("Out of memory allocating %zu bytes\n", bytes);
+			exit(1);
+		}
+		p->size[slot] = bytes;
+	}
+	return p->block[slot];
+}
+
+/**
+ * Free every buffer held by the pool
+ * @param p The pool
+ */
+static inline void pool_release(pool *p){
+	for(int i = 0; i < POOL_SLOTS; i++){
+		free(p->block[i]);
+		p->block[i] = NULL;
+		p->size[i] = 0;
+	}
+}
+
+#endif
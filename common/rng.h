@@ -0,0 +1,93 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * Seedable random numbers for the kernels (xoshiro256**). Every (parameter, trial) task of a sweep
+ * gets its own stream derived from the sweep seed, the parameter and the trial index (trial_stream in
+ * trial.h), so a task draws the same numbers whichever process or thread runs it and a sharded sweep
+ * reproduces a single process one.
+ */
+
+typedef struct rng{
+	uint64_t s[4];
+} rng;
+
+/**
+ * splitmix64 step, used to expand a seed into generator state
+ * @param  x The splitmix state
+ * @return   The next output
+ */
+static inline uint64_t rng_splitmix(uint64_t *x){
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Seed the stream of one task
+ * @param r      The generator
+ * @param seed   The seed of the sweep
+ * @param stream The stream of the task within the sweep
+ */
+static inline void rng_seed(rng *r, uint64_t seed, uint64_t stream){
+	uint64_t x = seed;
+	uint64_t mixed = rng_splitmix(&x) ^ stream;
+	x = mixed;
+	for(int i = 0; i < 4; i++){
+		r->s[i] = rng_splitmix(&x);
+	}
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k){
+	return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Next 64 random bits
+ * @param  r The generator
+ * @return   The bits
+ */
+static inline uint64_t rng_next(rng *r){
+	uint64_t result = rng_rotl(r->s[1] * 5, 7) * 9;
+	uint64_t t = r->s[1] << 17;
+	r->s[2] ^= r->s[0];
+	r->s[3] ^= r->s[1];
+	r->s[1] ^= r->s[2];
+	r->s[0] ^= r->s[3];
+	r->s[2] ^= t;
+	r->s[3] = rng_rotl(r->s[3], 45);
+	return result;
+}
+
+/**
+ * Uniform integer in [0, n) without modulo bias (Lemire's multiply and reject)
+ * @param  r The generator
+ * @param  n The bound
+ * @return   The integer
+ */
+static inline uint32_t rng_uniform(rng *r, uint32_t n){
+	uint64_t m = (rng_next(r) >> 32) * n;
+	uint32_t low = (uint32_t)m;
+	if(low < n){
+		uint32_t threshold = -n % n;
+		while(low < threshold){
+			m = (rng_next(r) >> 32) * n;
+			low = (uint32_t)m;
+		}
+	}
+	return m >> 32;
+}
+
+/**
+ * Uniform double in [0, 1)
+ * @param  r The generator
+ * @return   The double
+ */
+static inline double rng_double(rng *r){
+	return (rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+#endif
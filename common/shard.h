@@ -0,0 +1,113 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Sharded sweeps: process i of N runs the i-th contiguous range of the sweep's (parameter, trial)
+ * task indexes. Because every task seeds its own random stream from the sweep seed, the printed parameter
+ * and the trial index (trial_stream in trial.h), merging the shard files with mcs-merge gives exactly the
+ * results of a single process run with the same seed. Shard files start with a "#shard index count tasks
+ * k" header and prefix every trial line with its task index.
+ */
+
+typedef struct shard{
+	int index;
+	int count;
+} shard;
+
+/**
+ * Parse the leading options shared by the sweep programs: -s seed and -S index/count.
+ * The seed defaults to the current time.
+ * @param  argc The number of arguments
+ * @param  argv The arguments array
+ * @param  seed Set to the sweep seed
+ * @param  sh   Set to the shard, 0/1 when not sharded
+ * @return      The index of the first positional argument, -1 on a bad option
+ */
+static inline int shard_options(int argc, char *argv[], uint64_t *seed, shard *sh){
+	int opt;
+	*seed = (uint64_t)time(NULL);
+	sh->index = 0;
+	sh->count = 1;
+	//the leading + stops at the first positional argument with GNU getopt as well
+	while((opt = getopt(argc, argv, "+s:S:")) != -1){
+		if(opt == 's'){
+			*seed = strtoull(optarg, NULL, 10);
+		}
+		else if(opt == 'S' && sscanf(optarg, "%d/%d", &sh->index, &sh->count) == 2
+				&& sh->count > 0 && sh->index >= 0 && sh->index < sh->count){
+			continue;
+		}
+		else{
+			return -1;
+		}
+	}
+	return optind;
+}
+
+/**
+ * Whether the shard runs the given task
+ * @param  sh    The shard
+ * @param  task  The task index
+ * @param  tasks The number of tasks in the whole sweep
+ * @return       1 if the task belongs to this shard
+ */
+static inline int shard_owns(const shard *sh, int task, int tasks){
+	long long low = (long long)tasks * sh->index / sh->count;
+	long long high = (long long)tasks * (sh->index + 1) / sh->count;
+	return task >= low && task < high;
+}
+
+/**
+ * Number of tasks the shard runs
+ * @param  sh    The shard
+ * @param  tasks The number of tasks in the whole sweep
+ * @return       The tasks of this shard
+ */
+static inline int shard_task_count(const shard *sh, int tasks){
+	return (int)((long long)tasks * (sh->index + 1) / sh->count - (long long)tasks * sh->index / sh->count);
+}
+
+/**
+ * Append the shard suffix to a results file name when sharded
+ * @param file_name The results file name, with room for the suffix
+ * @param sh        The shard
+ */
+static inline void shard_file_name(char *file_name, const shard *sh){
+	if(sh->count > 1){
+		sprintf(file_name + strlen(file_name), ":shard-%d-of-%d", sh->index, sh->count);
+	}
+}
+
+/**
+ * Write the shard header when sharded
+ * @param f     The results file
+ * @param sh    The shard
+ * @param tasks The number of tasks in the whole sweep
+ * @param k     The number of trials for each parameter
+ */
+static inline void shard_write_header(FILE *f, const shard *sh, int tasks, int k){
+	if(sh->count > 1){
+		fprintf(f, "#shard %d %d %d %d\n", sh->index, sh->count, tasks, k);
+	}
+}
+
+/**
+ * Prefix a trial line with its task index when sharded
+ * @param f    The results file
+ * @param sh   The shard
+ * @param task The task index
+ */
+static inline void shard_write_task(FILE *f, const shard *sh, int task){
+	if(sh->count > 1){
+		fprintf(f, "%d ", task);
+	}
+}
+
+#endif
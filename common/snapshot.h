@@ -0,0 +1,389 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "trial.h"
+
+/**
+ * Lattice snapshot stream for watching two torus chains coalesce. Every `every` steps the hot loop packs
+ * the coupled lattice (X in bit 0 and Y in bit 1 of every site's byte) into one bit mask per chain and
+ * hands the frame to a writer thread through a small ring;
+ * if the writer is behind, the frame is dropped rather than stalling the chains. The writer forms the
+ * disagreement mask X ^ Y, run length encodes the three masks (alternating 0 / 1 bit runs as LEB128
+ * varints, falling back to the packed bits when that is shorter) straight into an append only memory
+ * mapped file, and appends the record's offset to an index file. File layout:
+ *   <name>.snap      snapshot_header, then snapshot_record + X, Y, X ^ Y masks per snapshot
+ *   <name>.snap.idx  one snapshot_entry per snapshot
+ * common/mcs-snapshot lists a stream and decodes snapshots to images.
+ */
+
+#define SNAPSHOT_MAGIC "MCSSNAP1"
+#define SNAPSHOT_SLOTS 4
+//the data file starts at this size and doubles when full
+#define SNAPSHOT_INITIAL_MAP (64UL << 20)
+#define SNAPSHOT_RAW 0
+#define SNAPSHOT_RLE 1
+
+typedef struct snapshot_header{
+	char magic[8];
+	uint32_t side;
+	uint32_t reserved;
+	uint64_t sites;
+} snapshot_header;
+
+typedef struct snapshot_record{
+	uint64_t iterations;
+	int64_t disagreement;
+	int32_t task;
+	//byte lengths and encodings of the X, Y and disagreement masks that follow
+	uint32_t length[3];
+	uint8_t encoding[3];
+	uint8_t reserved[5];
+} snapshot_record;
+
+typedef struct snapshot_entry{
+	uint64_t offset;
+	uint64_t iterations;
+	int32_t task;
+	uint32_t bytes;
+} snapshot_entry;
+
+typedef struct snapshot_frame{
+	int task;
+	unsigned long long iterations;
+	long long disagreement;
+	uint64_t *x;
+	uint64_t *y;
+} snapshot_frame;
+
+typedef struct snapshot{
+	unsigned long long every;
+	int side;
+	size_t sites;
+	size_t words;
+	//frames head - 1 ... tail are queued, the producer owns frame head, the writer frame tail
+	snapshot_frame frame[SNAPSHOT_SLOTS];
+	unsigned head;
+	unsigned tail;
+	int closing;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t space;
+	pthread_t writer;
+	//writer side
+	uint64_t *diff;
+	int fd;
+	FILE *index;
+	unsigned char *map;
+	size_t mapped;
+	size_t used;
+	unsigned long long written;
+	unsigned long long dropped;
+} snapshot;
+
+/**
+ * Append a LEB128 varint
+ * @param  out   The output
+ * @param  value The value
+ * @return       The bytes written
+ */
+static inline size_t snapshot_varint(unsigned char *out, uint64_t value){
+	size_t len = 0;
+	while(value >= 0x80){
+		out[len++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	out[len++] = (unsigned char)value;
+	return len;
+}
+
+/**
+ * Run length encode a bit mask as alternating 0 / 1 runs, starting with a (possibly empty) 0 run
+ * @param  bits  The mask, bits past sites are 0
+ * @param  sites The number of bits
+ * @param  out   The output, room for limit + 10 bytes
+ * @param  limit Give up once the encoding is longer than this
+ * @return       The encoded length, SIZE_MAX if over the limit
+ */
+static inline size_t snapshot_rle(const uint64_t *bits, size_t sites, unsigned char *out, size_t limit){
+	size_t len = 0, i = 0;
+	uint64_t fill = 0;
+	while(i < sites){
+		size_t start = i;
+		//skip whole words of the current value, then count into the first word that differs
+		while(i < sites){
+			uint64_t w = (bits[i >> 6] ^ fill) >> (i & 63);
+			if(w == 0){
+				i = (i | 63) + 1;
+				continue;
+			}
+			i += __builtin_ctzll(w);
+			break;
+		}
+		if(i > sites){
+			i = sites;
+		}
+		len += snapshot_varint(out + len, i - start);
+		if(len > limit){
+			return SIZE_MAX;
+		}
+		fill = ~fill;
+	}
+	return len;
+}
+
+/**
+ * Decode a mask written by snapshot_append
+ * @param  in       The encoded mask
+ * @param  length   Its length in bytes
+ * @param  encoding SNAPSHOT_RAW or SNAPSHOT_RLE
+ * @param  sites    The number of bits
+ * @param  bits     The decoded mask, (sites + 63) / 64 words
+ * @return          1 on success, 0 if the data is corrupt
+ */
+static inline int snapshot_decode(const unsigned char *in, size_t length, int encoding, size_t sites, uint64_t *bits){
+	size_t words = (sites + 63) / 64;
+	if(encoding == SNAPSHOT_RAW){
+		if(length != words * sizeof(uint64_t)){
+			return 0;
+		}
+		memcpy(bits, in, length);
+		return 1;
+	}
+	memset(bits, 0, words * sizeof(uint64_t));
+	size_t pos = 0, i = 0;
+	int value = 0;
+	while(pos < length){
+		uint64_t run = 0;
+		int shift = 0;
+		do{
+			if(pos >= length || shift > 63){
+				return 0;
+			}
+			run |= (uint64_t)(in[pos] & 0x7f) << shift;
+			shift += 7;
+		}while(in[pos++] & 0x80);
+		if(run > sites - i){
+			return 0;
+		}
+		if(value){
+			for(size_t b = i; b < i + run; b++){
+				bits[b >> 6] |= 1ULL << (b & 63);
+			}
+		}
+		i += run;
+		value ^= 1;
+	}
+	return i == sites;
+}
+
+/**
+ * Grow the data file and its mapping to hold at least bytes
+ * @param s     The stream
+ * @param bytes The size needed
+ */
+static inline void snapshot_reserve(snapshot *s, size_t bytes){
+	if(bytes <= s->mapped){
+		return;
+	}
+	size_t size = s->mapped ? s->mapped : SNAPSHOT_INITIAL_MAP;
+	while(size < bytes){
+		size *= 2;
+	}
+	if(s->map != NULL){
+		munmap(s->map, s->mapped);
+	}
+	if(ftruncate(s->fd, size) != 0){
+		printf("Error growing the snapshot file\n");
+		exit(1);
+	}
+	s->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+	if(s->map == MAP_FAILED){
+		printf("Error mapping the snapshot file\n");
+		exit(1);
+	}
+	s->mapped = size;
+}
+
+/**
+ * Encode one frame at the end of the data file and index it, on the writer thread
+ * @param s  The stream
+ * @param fr The frame
+ */
+static inline void snapshot_append(snapshot *s, const snapshot_frame *fr){
+	size_t raw = s->words * sizeof(uint64_t);
+	for(size_t w = 0; w < s->words; w++){
+		s->diff[w] = fr->x[w] ^ fr->y[w];
+	}
+	const uint64_t *mask[3] = {fr->x, fr->y, s->diff};
+	snapshot_record rec = {0};
+	rec.iterations = fr->iterations;
+	rec.disagreement = fr->disagreement;
+	rec.task = fr->task;
+	//room for the worst case, three raw masks plus the varint that crossed the limit
+	snapshot_reserve(s, s->used + sizeof(rec) + 3 * (raw + 10));
+	size_t offset = s->used, len = sizeof(rec);
+	for(int m = 0; m < 3; m++){
+		unsigned char *out = s->map + offset + len;
+		size_t encoded = snapshot_rle(mask[m], s->sites, out, raw);
+		if(encoded == SIZE_MAX){
+			memcpy(out, mask[m], raw);
+			encoded = raw;
+			rec.encoding[m] = SNAPSHOT_RAW;
+		}
+		else{
+			rec.encoding[m] = SNAPSHOT_RLE;
+		}
+		rec.length[m] = (uint32_t)encoded;
+		len += encoded;
+	}
+	memcpy(s->map + offset, &rec, sizeof(rec));
+	s->used += len;
+	snapshot_entry entry = {offset, fr->iterations, fr->task, (uint32_t)len};
+	fwrite(&entry, sizeof(entry), 1, s->index);
+	s->written++;
+}
+
+/**
+ * Writer thread, drains the ring until the stream is closed
+ * @param  arg The stream
+ * @return     not used
+ */
+static inline void *snapshot_writer(void *arg){
+	snapshot *s = arg;
+	pthread_mutex_lock(&s->lock);
+	while(1){
+		while(s->head == s->tail && !s->closing){
+			pthread_cond_wait(&s->wake, &s->lock);
+		}
+		if(s->head == s->tail){
+			break;
+		}
+		snapshot_frame *fr = &s->frame[s->tail % SNAPSHOT_SLOTS];
+		pthread_mutex_unlock(&s->lock);
+		snapshot_append(s, fr);
+		pthread_mutex_lock(&s->lock);
+		s->tail++;
+		pthread_cond_signal(&s->space);
+	}
+	pthread_mutex_unlock(&s->lock);
+	return NULL;
+}
+
+/**
+ * Create a snapshot stream and start its writer thread
+ * @param  path  The data file, the index goes to path.idx
+ * @param  side  The side of the torus
+ * @param  every The steps between snapshots
+ * @return       The stream
+ */
+static inline snapshot *snapshot_open(const char *path, int side, unsigned long long every){
+	snapshot *s = calloc(1, sizeof(snapshot));
+	s->every = every;
+	s->side = side;
+	s->sites = (size_t)side * side;
+	s->words = (s->sites + 63) / 64;
+	for(int i = 0; i < SNAPSHOT_SLOTS; i++){
+		s->frame[i].x = calloc(s->words, sizeof(uint64_t));
+		s->frame[i].y = calloc(s->words, sizeof(uint64_t));
+	}
+	s->diff = calloc(s->words, sizeof(uint64_t));
+	char index_name[strlen(path) + 5];
+	sprintf(index_name, "%s.idx", path);
+	s->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	s->index = fopen(index_name, "wb");
+	if(s->fd < 0 || NULL == s->index){
+		printf("Error opening snapshot file %s\n", path);
+		exit(1);
+	}
+	snapshot_reserve(s, sizeof(snapshot_header));
+	snapshot_header header = {{0}, (uint32_t)side, 0, s->sites};
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	memcpy(s->map, &header, sizeof(header));
+	s->used = sizeof(header);
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->wake, NULL);
+	pthread_cond_init(&s->space, NULL);
+	pthread_create(&s->writer, NULL, snapshot_writer, s);
+	return s;
+}
+
+/**
+ * Queue a snapshot of the chains from the hot loop and schedule the next one. Only the bit packing runs
+ * on the calling thread.
+ * @param t            The trial, t->snap is the stream
+ * @param iterations   The iterations so far
+ * @param disagreement The number of sites where the chains differ
+ * @param S            The coupled lattice, n * n sites with X in bit 0 and Y in bit 1
+ * @param wait         1 to wait for the writer when the ring is full, 0 to drop the snapshot
+ */
+static inline void snapshot_take(trial *t, unsigned long long iterations, long long disagreement, const uint8_t *S, int wait){
+	snapshot *s = t->snap;
+	t->snap_at = iterations + s->every;
+	pthread_mutex_lock(&s->lock);
+	while(s->head - s->tail == SNAPSHOT_SLOTS && wait){
+		pthread_cond_wait(&s->space, &s->lock);
+	}
+	if(s->head - s->tail == SNAPSHOT_SLOTS){
+		s->dropped++;
+		pthread_mutex_unlock(&s->lock);
+		return;
+	}
+	snapshot_frame *fr = &s->frame[s->head % SNAPSHOT_SLOTS];
+	pthread_mutex_unlock(&s->lock);
+	fr->task = t->task;
+	fr->iterations = iterations;
+	fr->disagreement = disagreement;
+	for(size_t w = 0; w < s->words; w++){
+		uint64_t x = 0, y = 0;
+		size_t base = w * 64, end = base + 64 < s->sites ? base + 64 : s->sites;
+		for(size_t i = base; i < end; i++){
+			x |= (uint64_t)(S[i] & 1) << (i - base);
+			y |= (uint64_t)(S[i] >> 1 & 1) << (i - base);
+		}
+		fr->x[w] = x;
+		fr->y[w] = y;
+	}
+	pthread_mutex_lock(&s->lock);
+	s->head++;
+	pthread_cond_signal(&s->wake);
+	pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * Flush the queued snapshots, stop the writer and trim the data file to its contents
+ * @param s The stream, NULL is ignored
+ */
+static inline void snapshot_close(snapshot *s){
+	if(s == NULL){
+		return;
+	}
+	pthread_mutex_lock(&s->lock);
+	s->closing = 1;
+	pthread_cond_signal(&s->wake);
+	pthread_mutex_unlock(&s->lock);
+	pthread_join(s->writer, NULL);
+	munmap(s->map, s->mapped);
+	if(ftruncate(s->fd, s->used) != 0){
+		printf("Error trimming the snapshot file\n");
+	}
+	close(s->fd);
+	fclose(s->index);
+	printf("snapshots: %llu written, %llu dropped, %zu bytes\n", s->written, s->dropped, s->used);
+	for(int i = 0; i < SNAPSHOT_SLOTS; i++){
+		free(s->frame[i].x);
+		free(s->frame[i].y);
+	}
+	free(s->diff);
+	free(s);
+}
+
+#endif
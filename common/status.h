@@ -0,0 +1,231 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+ * Live status page for a running sweep. The page is a small file mapped shared into memory,
+ * the sweep writes into it and mcs-status maps the same file read only. Every worker slot is
+ * guarded by a sequence counter (seqlock) so the hot loop never waits on a reader: the writer
+ * makes the counter odd, updates the fields and makes it even again, the reader retries until
+ * it sees the same even value before and after copying the slot.
+ */
+
+#define STATUS_MAGIC         0x4d435332
+#define STATUS_MAX_WORKERS   64
+//publish from the hot loop once every 2^20 iterations
+#define STATUS_PUBLISH_MASK  ((1ULL << 20) - 1)
+
+typedef struct status_worker{
+	atomic_uint seq;
+	int active;
+	double param;
+	int trial;
+	unsigned long long iterations;
+	long long disagreement;
+	double steps_per_sec;
+	double task_started;
+	double updated;
+	//writer private bookkeeping for the rate, not part of the snapshot
+	double last_time;
+	unsigned long long last_iterations;
+} status_worker;
+
+typedef struct status_page{
+	unsigned magic;
+	int pid;
+	char model[32];
+	long long n;
+	int k;
+	double p_low;
+	double p_high;
+	double p_step;
+	double started;
+	int workers;
+	atomic_int tasks_total;
+	atomic_int tasks_done;
+	status_worker worker[STATUS_MAX_WORKERS];
+} status_page;
+
+//the page of this process (NULL when telemetry could not be set up) and the slot of this thread
+static status_page *status = NULL;
+static _Thread_local int status_worker_id = 0;
+
+/**
+ * Seconds on the monotonic clock, shared by the sweep and the reader
+ * @return the current time in seconds
+ */
+static inline double status_now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Create the status page for a sweep and map it into memory. Failure is not fatal,
+ * the sweep simply runs without telemetry.
+ * @param  path        The file backing the page
+ * @param  model       The model name shown by the reader
+ * @param  n           The size of the graph
+ * @param  k           The number of trials for each parameter
+ * @param  p_low       The parameter to start at
+ * @param  p_high      The parameter to end at
+ * @param  p_step      The increment for the parameter
+ * @param  tasks_total The number of (parameter, trial) tasks in the sweep
+ * @param  workers     The number of worker slots in use
+ * @return             The mapped page or NULL
+ */
+static inline status_page *status_open(const char *path, const char *model, long long n, int k,
+		double p_low, double p_high, double p_step, int tasks_total, int workers){
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0){
+		printf("Could not create status page %s, running without telemetry\n", path);
+		return NULL;
+	}
+	if(ftruncate(fd, sizeof(status_page)) != 0){
+		close(fd);
+		printf("Could not size status page %s, running without telemetry\n", path);
+		return NULL;
+	}
+	status_page *page = mmap(NULL, sizeof(status_page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(page == MAP_FAILED){
+		printf("Could not map status page %s, running without telemetry\n", path);
+		return NULL;
+	}
+	memset(page, 0, sizeof(status_page));
+	page->pid = getpid();
+	snprintf(page->model, sizeof(page->model), "%s", model);
+	page->n = n;
+	page->k = k;
+	page->p_low = p_low;
+	page->p_high = p_high;
+	page->p_step = p_step;
+	page->started = status_now();
+	page->workers = workers < STATUS_MAX_WORKERS ? workers : STATUS_MAX_WORKERS;
+	atomic_store(&page->tasks_total, tasks_total);
+	//publish the magic last so a reader never sees a half initialized header
+	atomic_thread_fence(memory_order_release);
+	page->magic = STATUS_MAGIC;
+	return page;
+}
+
+/**
+ * Unmap the page, the file is left behind holding the final state of the sweep
+ * @param page The page to close
+ */
+static inline void status_close(status_page *page){
+	if(page != NULL){
+		munmap(page, sizeof(status_page));
+	}
+}
+
+/**
+ * Open a seqlock write section on a worker slot
+ * @param w The slot to write
+ */
+static inline void status_write_begin(status_worker *w){
+	unsigned s = atomic_load_explicit(&w->seq, memory_order_relaxed);
+	atomic_store_explicit(&w->seq, s + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * Close a seqlock write section on a worker slot
+ * @param w The slot written
+ */
+static inline void status_write_end(status_worker *w){
+	unsigned s = atomic_load_explicit(&w->seq, memory_order_relaxed);
+	atomic_store_explicit(&w->seq, s + 1, memory_order_release);
+}
+
+/**
+ * Mark the start of a (parameter, trial) task on the calling worker
+ * @param param The parameter of the task
+ * @param trial The trial index of the task
+ */
+static inline void status_begin_task(double param, int trial){
+	if(status == NULL){
+		return;
+	}
+	status_worker *w = &status->worker[status_worker_id];
+	double now = status_now();
+	status_write_begin(w);
+	w->active = 1;
+	w->param = param;
+	w->trial = trial;
+	w->iterations = 0;
+	w->disagreement = -1;
+	w->steps_per_sec = 0;
+	w->task_started = now;
+	w->updated = now;
+	status_write_end(w);
+	w->last_time = now;
+	w->last_iterations = 0;
+}
+
+/**
+ * Publish progress of the current task, called from the hot loop every STATUS_PUBLISH_MASK + 1 iterations
+ * @param iterations   The iterations so far
+ * @param disagreement The current number of disagreeing vertexes (or the model's analogue)
+ */
+static inline void status_tick(unsigned long long iterations, long long disagreement){
+	if(status == NULL){
+		return;
+	}
+	status_worker *w = &status->worker[status_worker_id];
+	double now = status_now();
+	double rate = w->steps_per_sec;
+	if(now > w->last_time){
+		rate = (iterations - w->last_iterations) / (now - w->last_time);
+	}
+	status_write_begin(w);
+	w->iterations = iterations;
+	w->disagreement = disagreement;
+	w->steps_per_sec = rate;
+	w->updated = now;
+	status_write_end(w);
+	w->last_time = now;
+	w->last_iterations = iterations;
+}
+
+/**
+ * Mark the end of the current task on the calling worker
+ * @param iterations The iterations the task took
+ */
+static inline void status_end_task(unsigned long long iterations){
+	if(status == NULL){
+		return;
+	}
+	status_worker *w = &status->worker[status_worker_id];
+	status_write_begin(w);
+	w->active = 0;
+	w->iterations = iterations;
+	w->disagreement = 0;
+	w->updated = status_now();
+	status_write_end(w);
+	atomic_fetch_add(&status->tasks_done, 1);
+}
+
+/**
+ * Take a consistent copy of a worker slot without blocking the writer
+ * @param w   The slot in the shared page
+ * @param out Where to copy the slot to
+ */
+static inline void status_snapshot(const status_worker *w, status_worker *out){
+	unsigned s1, s2;
+	do{
+		s1 = atomic_load_explicit((atomic_uint *)&w->seq, memory_order_acquire);
+		memcpy(out, (const void *)w, sizeof(status_worker));
+		atomic_thread_fence(memory_order_acquire);
+		s2 = atomic_load_explicit((atomic_uint *)&w->seq, memory_order_relaxed);
+	} while((s1 & 1) || s1 != s2);
+}
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "trial.h"
+#include "censor.h"
+#include "shard.h"
+#include "cache.h"
+#include "autocorr.h"
+#include "snapshot.h"
+
+/**
+ * The sweep every model program runs. A model file declares its kernels and one model entry describing
+ * them, and its main is sweep_main; the tools that run several models in one process (models.h) list the
+ * same entries. Options, file naming, the trial cache, status, shards and the Kaplan-Meier summary are
+ * handled here once for every model. The kernel is called once per trial, so the sweep costs nothing
+ * per step; the hot loop stays in the model's own mix_chains.
+ */
+
+#define MAX_OBSERVABLES 3
+#define MAX_SPINS 16
+
+//model files fill it with designated initializers, members they leave out are 0 or NULL
+typedef struct model{
+	//the model in the trial cache and the batch runner
+	const char *name;
+	//the prefix of the batch runner's results file, also shown by mcs-status
+	const char *prefix;
+	//the standalone results file, a format taking n, k, low, high, step and seed
+	const char *results;
+	//the name of the parameter for the console
+	const char *param;
+	//1 if n is the side of an n x n torus, 0 if it is the vertex count
+	int torus;
+	//the engine version keying the kernel's trials in the trial cache (cache.h)
+	const int *version;
+	unsigned long long (*mix)(int n, double param, trial *t);
+	//single chain run recording observables once per sweep, NULL if the model has none
+	unsigned long long (*relax)(int n, double param, trial *t, series *obs);
+	int observables;
+	const char *observable[MAX_OBSERVABLES];
+	//1 if mix feeds t->snap (snapshot.h), so the program takes -V
+	int snapshots;
+	//approximate chains for n past int, run with -L eps; NULL if the model has none
+	unsigned long long (*leap)(long long n, double param, double eps, trial *t);
+	//the chains of mix with one trial on t->threads threads, the same trials, run with -P threads; NULL if
+	//the model has none
+	unsigned long long (*parallel)(int n, double param, trial *t);
+	//bounding chain coupling from the past, run with -C, returning the certified coupling time and setting the
+	//number of vertexes at each spin of its exact sample; NULL if the model has none
+	unsigned long long (*cftp)(int n, double param, trial *t, long long *sample);
+	//the spins of a sample
+	int spins;
+} model;
+
+typedef struct sweep{
+	long long n;
+	int k;
+	double low;
+	double high;
+	double step;
+	//the steps between lattice snapshots, 0 for none
+	unsigned long long snapshot_every;
+	//the error tolerance of the leaping chains, 0 to run the exact chains
+	double leap_eps;
+	//the threads of one trial, 1 to run mix
+	int threads;
+	//1 to run the coupling from the past chains
+	int cftp;
+} sweep;
+
+/**
+ * Number of parameters in a sweep, low, low + step, ... up to high. The parameters are computed from
+ * their index rather than by adding step up, which drifts and could drop high
+ * @param  low  The parameter to start at
+ * @param  high The parameter to end at
+ * @param  step The increment for the parameter
+ * @return      The number of parameters
+ */
+static inline int sweep_count(double low, double high, double step){
+	if(step <= 0){
+		return 1;
+	}
+	if(high < low){
+		return 0;
+	}
+	return (int)floor((high - low) / step + 1e-9) + 1;
+}
+
+/**
+ * The index-th parameter of a sweep
+ * @param  low   The parameter to start at
+ * @param  step  The increment for the parameter
+ * @param  index The parameter index
+ * @return       The parameter
+ */
+static inline double sweep_param(double low, double step, int index){
+	return low + index * step;
+}
+
+/**
+ * Count the (parameter, trial) tasks in a sweep
+ * @param  k    The number of trials for each parameter
+ * @param  low  The parameter to start at
+ * @param  high The parameter to end at
+ * @param  step The increment for the parameter
+ * @return      The number of tasks
+ */
+static inline int sweep_tasks(int k, double low, double high, double step){
+	return k * sweep_count(low, high, step);
+}
+
+/**
+ * Run a sweep of a model, writing the results file, its .km summary and status page
+ * @param m  The model
+ * @param sw The sweep
+ * @param t  The per trial budget
+ * @param sh The shard of the sweep to run
+ */
+static inline void sweep_run(const model *m, const sweep *sw, trial *t, shard *sh){
+	int k = sw->k;
+	unsigned long long iterations;
+	int params = sweep_count(sw->low, sw->high, sw->step);
+	int tasks = sweep_tasks(k, sw->low, sw->high, sw->step);
+	char file_name[200];
+	sprintf(file_name, m->results, sw->n, k, sw->low, sw->high, sw->step, (unsigned long long)t->seed);
+	//the leaping chains are an approximation, their results and cached trials are kept apart
+	char cache_name[64];
+	if(sw->leap_eps > 0){
+		sprintf(file_name + strlen(file_name), ":leap-%g", sw->leap_eps);
+		snprintf(cache_name, sizeof(cache_name), "%s-leap-%g", m->name, sw->leap_eps);
+	}
+	else if(sw->cftp){
+		strcat(file_name, ":cftp");
+	}
+	else{
+		snprintf(cache_name, sizeof(cache_name), "%s", m->name);
+	}
+	shard_file_name(file_name, sh);
+	FILE *f = fopen(file_name, "w");
+	if(NULL == f){
+		printf("Error opening results file");
+		exit(1);
+	}
+	shard_write_header(f, sh, tasks, k);
+	char status_name[210];
+	sprintf(status_name, "%s.status", file_name);
+	status = status_open(status_name, m->prefix, sw->n, k, sw->low, sw->high, sw->step, shard_task_count(sh, tasks), 1);
+	//a shard holds only part of the trials of a parameter, mcs-merge writes the summary of a sharded sweep
+	FILE *km = NULL;
+	if(sh->count == 1){
+		char km_name[210];
+		sprintf(km_name, "%s.km", file_name);
+		km = fopen(km_name, "w");
+		if(NULL == km){
+			printf("Error opening summary file");
+			exit(1);
+		}
+	}
+	if(sw->snapshot_every > 0 && !sw->cftp){
+		char snapshot_name[210];
+		sprintf(snapshot_name, "%s.snap", file_name);
+		t->snap = snapshot_open(snapshot_name, (int)sw->n, sw->snapshot_every);
+	}
+	//the exact samples of coupling from the past, one "param index count_0 ... count_q-1" line per coupled trial
+	FILE *samples = NULL;
+	if(sw->cftp){
+		char samples_name[210];
+		sprintf(samples_name, "%s.samples", file_name);
+		samples = fopen(samples_name, "w");
+		if(NULL == samples){
+			printf("Error opening samples file");
+			exit(1);
+		}
+	}
+	//the cache keeps no samples, which are the point of coupling from the past, so those runs leave it closed
+	cache trials = {0};
+	if(!sw->cftp){
+		cache_open(&trials, cache_name, *m->version, sw->n, t->seed);
+	}
+	long long sample[MAX_SPINS];
+	observation *obs = malloc(k * sizeof(observation));
+	pool scratch = {0};
+	t->scratch = &scratch;
+	int task = 0;
+	for(int p = 0; p < params; p++){
+		double param = sweep_param(sw->low, sw->step, p);
+		for(int i = 0; i < k; i++, task++){
+			if(!shard_owns(sh, task, tasks)){
+				continue;
+			}
+			status_begin_task(param, i);
+			trial_start(t, task, param, i);
+			//trials an overlapping sweep already ran come from the cache
+			if(!cache_lookup(&trials, param, i, t, &iterations)){
+				if(sw->leap_eps > 0){
+					iterations = m->leap(sw->n, param, sw->leap_eps, t);
+				}
+				else if(sw->cftp){
+					iterations = m->cftp((int)sw->n, param, t, sample);
+					if(!t->censored){
+						fprintf(samples, "%f %d", param, i);
+						for(int s = 0; s < m->spins; s++){
+							fprintf(samples, " %lld", sample[s]);
+						}
+						fprintf(samples, "\n");
+					}
+				}
+				else if(sw->threads > 1){
+					iterations = m->parallel((int)sw->n, param, t);
+				}
+				else{
+					iterations = m->mix((int)sw->n, param, t);
+				}
+				cache_store(&trials, param, i, t, iterations);
+			}
+			status_end_task(iterations);
+			obs[i].time = iterations;
+			obs[i].censored = t->censored;
+			shard_write_task(f, sh, task);
+			trial_record(f, m->param, param, i, iterations, t);
+		}
+		if(km != NULL){
+			km_write_summary(km, param, obs, k);
+		}
+	}
+	fclose(f);
+	if(samples != NULL){
+		fclose(samples);
+	}
+	if(km != NULL){
+		fclose(km);
+	}
+	free(obs);
+	pool_release(&scratch);
+	snapshot_close(t->snap);
+	if(trials.enabled){
+		printf("trial cache: %llu hits, %llu runs\n", (unsigned long long)trials.hits, (unsigned long long)trials.misses);
+	}
+	status_close(status);
+}
+
+/**
+ * Main method of a model program: [-V every] [-L eps] [-P threads] [-C] [-s seed] [-S shard/shards] n k low
+ * high step [max_steps [max_seconds]]. -V is taken by models that record snapshots, -L by models with leaping
+ * chains, -P by models with a parallel kernel and -C by models with coupling from the past.
+ * @param  argc The number of arguments
+ * @param  argv The arguments array
+ * @param  m    The model
+ * @return      0 on success
+ */
+static inline int sweep_main(int argc, char *argv[], const model *m){
+	sweep sw = {0};
+	//set by a bad option value, reported with the usage message
+	int bad = 0;
+	//the model's own options come first and are stripped before the shared -s and -S
+	while((argc > 1 && m->cftp != NULL && strcmp(argv[1], "-C") == 0) || (argc > 2 && ((m->snapshots && strcmp(argv[1], "-V") == 0)
+			|| (m->leap != NULL && strcmp(argv[1], "-L") == 0) || (m->parallel != NULL && strcmp(argv[1], "-P") == 0)))){
+		//-C takes no value
+		if(argv[1][1] == 'C'){
+			sw.cftp = 1;
+			argv[1] = argv[0];
+			argc--;
+			argv++;
+			continue;
+		}
+		if(argv[1][1] == 'V'){
+			sw.snapshot_every = strtoull(argv[2], NULL, 10);
+		}
+		else if(argv[1][1] == 'L'){
+			sw.leap_eps = atof(argv[2]);
+			//an eps of 0 would silently run the exact chains
+			bad |= !(sw.leap_eps > 0);
+		}
+		else{
+			sw.threads = atoi(argv[2]);
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+	//optional -s seed and -S index/count to run one shard of the sweep
+	trial t = {0};
+	shard sh;
+	int a = shard_options(argc, argv, &t.seed, &sh);
+	if (bad || a < 0 || argc - a < 5 || argc - a > 7 || atoi(argv[a + 1]) < 1){
+		printf("Must supply %s%s%s%s[-s seed] [-S shard/shards] n, k, %s_low, %s_high, %s_step and optionally max_steps, max_seconds space delimited",
+			m->snapshots ? "[-V every] " : "", m->leap != NULL ? "[-L eps] " : "", m->parallel != NULL ? "[-P threads] " : "",
+			m->cftp != NULL ? "[-C] " : "",
+			m->param, m->param, m->param);
+		return 1;
+	}
+	sw.n = strtoll(argv[a], NULL, 10);
+	sw.k = atoi(argv[a + 1]);
+	//only the leaping chains go past int vertexes, they never store the graph
+	if(sw.n < 1 || (sw.leap_eps <= 0 && sw.n > INT_MAX)){
+		printf("n must be between 1 and %d%s\n", INT_MAX, m->leap != NULL ? ", or larger with -L" : "");
+		return 1;
+	}
+	sw.low = atof(argv[a + 2]);
+	sw.high = atof(argv[a + 3]);
+	sw.step = atof(argv[a + 4]);
+	//optional per trial budget, trials that exceed it are recorded as censored
+	if(argc - a > 5){
+		t.max_steps = strtoull(argv[a + 5], NULL, 10);
+	}
+	if(argc - a > 6){
+		t.max_seconds = atof(argv[a + 6]);
+	}
+	t.threads = sw.threads;
+	sweep_run(m, &sw, &t, &sh);
+	return 0;
+}
+
+#endif
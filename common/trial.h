@@ -0,0 +1,145 @@
+#ifndef TRIAL_H
+#define TRIAL_H
+
+#include <limits.h>
+#include "status.h"
+#include "pool.h"
+#include "rng.h"
+
+/**
+ * Per trial state handed to mix_chains. The caller sets the budget, mix_chains reports whether the
+ * trial coupled or ran out of budget (a right censored observation) and the disagreement it stopped at.
+ * A budget of 0 means unlimited. scratch holds the buffers mix_chains reuses from trial to trial and
+ * stream is the random stream of the current trial, seeded from seed, the parameter and the trial index. snap, when set,
+ * is the snapshot stream the torus kernels feed every snap->every steps (see snapshot.h).
+ */
+struct snapshot;
+
+typedef struct trial{
+	unsigned long long max_steps;
+	double max_seconds;
+	int censored;
+	long long last_disagreement;
+	//the iteration at which the hot loop next calls trial_check
+	unsigned long long check_at;
+	double deadline;
+	pool *scratch;
+	uint64_t seed;
+	rng stream;
+	int task;
+	struct snapshot *snap;
+	//the iteration of the next snapshot, ULLONG_MAX without a stream
+	unsigned long long snap_at;
+	//the threads a parallel kernel may run one trial on
+	int threads;
+} trial;
+
+/**
+ * Next iteration at which the hot loop has to look at the budget or publish status
+ * @param  t          The trial
+ * @param  iterations The iterations so far
+ * @return            The iteration of the next check
+ */
+static inline unsigned long long trial_next_check(const trial *t, unsigned long long iterations){
+	unsigned long long next = (iterations | STATUS_PUBLISH_MASK) + 1;
+	if(t->max_steps > 0 && t->max_steps < next){
+		next = t->max_steps;
+	}
+	if(t->snap_at < next){
+		next = t->snap_at;
+	}
+	return next;
+}
+
+/**
+ * Stream of the index-th trial at a parameter. It is keyed by the parameter as results files print it
+ * rather than by the task's position in the sweep, so overlapping sweeps with the same seed draw the
+ * same trials and can share the trial cache (cache.h)
+ * @param  param The parameter
+ * @param  index The trial index for this parameter
+ * @return       The stream passed to rng_seed
+ */
+static inline uint64_t trial_stream(double param, int index){
+	char text[64];
+	snprintf(text, sizeof(text), "%f", param);
+	//FNV-1a of the printed parameter, with the trial index in the low bits
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for(const char *c = text; *c != '\0'; c++){
+		h = (h ^ (unsigned char)*c) * 0x100000001b3ULL;
+	}
+	return (h << 20) ^ (uint64_t)index;
+}
+
+/**
+ * Reset the outcome, seed the trial's random stream and arm the budget, call before every mix_chains
+ * @param t     The trial
+ * @param task  The index of the task within the sweep
+ * @param param The parameter of the trial
+ * @param index The trial index for this parameter
+ */
+static inline void trial_start(trial *t, int task, double param, int index){
+	rng_seed(&t->stream, t->seed, trial_stream(param, index));
+	t->task = task;
+	t->snap_at = t->snap != NULL ? 0 : ULLONG_MAX;
+	t->censored = 0;
+	t->last_disagreement = 0;
+	t->deadline = t->max_seconds > 0 ? status_now() + t->max_seconds : 0;
+	t->check_at = trial_next_check(t, 0);
+}
+
+/**
+ * Slow path of the hot loop, taken once iterations reaches t->check_at: publish status
+ * and stop the trial if it used up its step or wall clock budget
+ * @param  t            The trial
+ * @param  iterations   The iterations done so far
+ * @param  disagreement The current disagreement of the chains
+ * @return              1 if the trial is censored and the chains must stop
+ */
+static inline int trial_check(trial *t, unsigned long long iterations, long long disagreement){
+	status_tick(iterations, disagreement);
+	if((t->max_steps > 0 && iterations >= t->max_steps) || (t->deadline > 0 && status_now() >= t->deadline)){
+		t->censored = 1;
+		t->last_disagreement = disagreement;
+		return 1;
+	}
+	t->check_at = trial_next_check(t, iterations);
+	return 0;
+}
+
+/**
+ * Write one trial to a results file. Coupled trials keep the "param iterations" line,
+ * censored ones append "censored last_disagreement"
+ * @param f          The results file
+ * @param param      The parameter of the trial
+ * @param iterations The iterations the trial ran
+ * @param t          The finished trial
+ */
+static inline void trial_write(FILE *f, double param, unsigned long long iterations, const trial *t){
+	if(t->censored){
+		fprintf(f, "%f %llu censored %lld\n", param, iterations, t->last_disagreement);
+	}
+	else{
+		fprintf(f, "%f %llu\n", param, iterations);
+	}
+}
+
+/**
+ * Write one trial to the results file and the console
+ * @param f          The results file
+ * @param name       The name of the parameter for the console
+ * @param param      The parameter of the trial
+ * @param index      The trial index for this parameter
+ * @param iterations The iterations the trial ran
+ * @param t          The finished trial
+ */
+static inline void trial_record(FILE *f, const char *name, double param, int index, unsigned long long iterations, const trial *t){
+	trial_write(f, param, iterations, t);
+	if(t->censored){
+		printf("%s: %f, k: %d, censored at iterations: %llu, disagreement: %lld\n", name, param, index, iterations, t->last_disagreement);
+	}
+	else{
+		printf("%s: %f, k: %d, iterations: %llu\n", name, param, index, iterations);
+	}
+}
+
+#endif
@@ -2,199 +2,158 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include "../common/sweep.h"
 
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 2;
+unsigned long long mix_chains(int n, double beta, trial *t);
+unsigned long long relax_chain(int n, double lambda, trial *t, series *obs);
 
-void simulation(int n, int k, double lambda_low, double lambda_high, double lambda_step);
-int mix_chains(int n, double beta);
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ */
+const model model_entry = {
+	.name = "hardcore",
+	.prefix = "independent-set-heat-bath",
+	.results = "results/independent-set-heat-bath:%lld:%d:%f:%f:%f:%llu",
+	.param = "lambda",
+	.torus = 1,
+	.version = &engine_version,
+	.mix = mix_chains,
+	.relax = relax_chain,
+	.observables = 1,
+	.observable = {"density"},
+	.snapshots = 1,
+};
 
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
 /**
  * Main method wrapper
  * @param  argc the number of arguments
  * @param  argv the arguments array
- * @return      not used
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, lambda_low, lambda_high, lambda_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double lambda_low = atof(argv[3]);
-	double lambda_high = atof(argv[4]);
-	double lambda_step = atof(argv[5]);
-	srand(time(NULL));
-	simulation(n, k, lambda_low, lambda_high, lambda_step);
-
-}
-
-/**
- * Run the simulation with the specified parameters.
- * @param n      The size of the graph (complete graph) n= vertex count
- * @param k      The number of iterations for each lambda
- * @param a_low  The lambda to begin with
- * @param a_high The lambda to end with
- * @param a_step The lambda to step with 
- */
-void simulation(int n, int k, double lambda_low, double lambda_high, double lambda_step){
-	double lambda = lambda_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/independent-set-heat-bath:%d:%d:%f:%f:%f:%d", n, k, lambda_low, lambda_high, lambda_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	while(lambda <= lambda_high){
-		for(int i = 0; i < k; i++){
-			iterations = mix_chains(n, lambda);
-			fprintf(f, "%f %d\n", lambda, iterations);
-			printf("lambda: %f, k: %d, iterations: %d\n", lambda, i, iterations);
-		}
-		lambda += lambda_step;
-	}
-	fclose(f);
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
  * Run even and odd occupied starting chains until they couple
  * and report the required number of iterations
  * @param  n     The size of the chains
  * @param  lambda The lambda for the partition function
+ * @param  t      The trial budget, set to censored if it runs out
  * @return       The iterations needed for mixing
  */
-int mix_chains(int n, double lambda){
-	//we are on the graph K_n so we represent X and Y by two lists and counts for bookkeeping
-	int X[n][n];
-	int Y[n][n];
+unsigned long long mix_chains(int n, double lambda, trial *t){
+	//X and Y of a site share one byte, bit 0 set when the site is occupied in X and bit 1 in Y, so one
+	//gather of the 4 neighbors serves both chains and a site disagrees exactly when its two bits differ
+	//the lattice comes from the scratch pool so it is reused across trials instead of living on the stack
+	uint8_t (*S)[n] = pool_get(t->scratch, 0, (size_t)n * n);
 
+	//X starts with the even sites occupied and Y with the odd
 	int global_diff_count = n * n;
 	for(int i = 0; i < n; i++){
 		for(int j = 0; j < n; j++){
-			if((i +j) % 2 == 0){
-				X[i][j] = 1;
-				Y[i][j] = 0;
-			}
-			else{
-				X[i][j] = 0;
-				Y[i][j] = 1;
-			}
+			S[i][j] = (i + j) % 2 == 0 ? 1 : 2;
 		}
 	}
 
 
 	unsigned long long iterations = 0;
-	// +1 / -1 for spins
 
-	int v_x, v_y, flag, v_x_new, v_y_new, started_same;
-	double occupation_prob, r;
+	int v_x, v_y, up, down, left, right;
+	uint8_t old, now, blocked;
+	double occupation_prob = lambda / (lambda + 1), r;
 
 	while (global_diff_count > 0){
 
+		if(iterations >= t->check_at){
+			//snapshots share the check point so the hot loop keeps a single comparison
+			if(iterations >= t->snap_at){
+				snapshot_take(t, iterations, global_diff_count, &S[0][0], 0);
+			}
+			if(trial_check(t, iterations, global_diff_count)){
+				break;
+			}
+		}
 		iterations += 1;
-		v_x = rand() % n;
-		v_y = rand() % n;
-		started_same = X[v_x][v_y] - Y[v_x][v_y];
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
 
-		occupation_prob = lambda / (lambda + 1);
+		r = rng_double(&t->stream);
 
-		r = (float)rand()/(float)RAND_MAX;
-		
+		old = S[v_x][v_y];
 		if (r <= occupation_prob){
-			//check the neighbors to ensure valid IS
-			flag = 1;
-			v_x_new = (v_x + 1) % n;
-			if(Y[v_x_new][v_y] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_y_new = (v_y + 1) % n;
-			if(Y[v_x][v_y_new] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_x_new = v_x - 1;
-			if(v_x_new < 0){
-				v_x_new += n;
-			}
-			if(Y[v_x_new][v_y] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_y_new = v_y - 1;
-			if(v_y_new < 0){
-				v_y_new += n;
-			}
-			if(Y[v_x][v_y_new] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			if(flag){
-				Y[v_x][v_y] = 1;
-			}
+			//a chain may occupy the site only if none of its neighbors (with wrap around) are occupied
+			up = v_x == 0 ? n - 1 : v_x - 1;
+			down = v_x == n - 1 ? 0 : v_x + 1;
+			left = v_y == 0 ? n - 1 : v_y - 1;
+			right = v_y == n - 1 ? 0 : v_y + 1;
+			blocked = S[down][v_y] | S[up][v_y] | S[v_x][right] | S[v_x][left];
+			now = old | (~blocked & 3);
 		}
 		else{
-			Y[v_x][v_y] = 0;	
+			now = 0;
 		}
-		if (r <= occupation_prob){
-			//check the neighbors to ensure valid IS
-			flag = 1;
-			v_x_new = (v_x + 1) % n;
-			if(X[v_x_new][v_y] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_y_new = (v_y + 1) % n;
-			if(X[v_x][v_y_new] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_x_new = v_x - 1;
-			if(v_y_new < 0){
-				v_x_new += n;
-			}
-			if(X[v_x_new][v_y] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			v_y_new = v_y - 1;
-			if(v_y_new < 0){
-				v_y_new += n;
-			}
-			if(X[v_x][v_y_new] != 1){
-				flag &= 1;
-			}
-			else{
-				flag &= 0;
-			}
-			if(flag){
-				X[v_x][v_y] = 1;
-			}		
+		S[v_x][v_y] = now;
+		global_diff_count += ((now ^ now >> 1) & 1) - ((old ^ old >> 1) & 1);
+	}
+	//the last frame, coupled or censored, is never dropped
+	if(t->snap != NULL){
+		snapshot_take(t, iterations, global_diff_count, &S[0][0], 1);
+	}
+	return iterations;
+}
+
+/**
+ * Run the even occupied chain alone for the trial's step budget and record its occupation density
+ * once every sweep (n * n steps), for the single long run autocorrelation estimator
+ * @param  n      The size of the torus
+ * @param  lambda The lambda for the partition function
+ * @param  t      The trial, its step budget is the length of the run
+ * @param  obs    The occupation density series
+ * @return        The iterations run
+ */
+unsigned long long relax_chain(int n, double lambda, trial *t, series *obs){
+	int (*X)[n] = pool_get(t->scratch, 0, (size_t)n * n * sizeof(int));
+	unsigned long long iterations = 0, sweep = (unsigned long long)n * n;
+	long long occupied = 0;
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j < n; j++){
+			X[i][j] = (i + j) % 2 == 0;
+			occupied += X[i][j];
 		}
-		else{
-			X[v_x][v_y] = 0;		
+	}
+	double occupation_prob = lambda / (lambda + 1);
+	int v_x, v_y;
+
+	unsigned long long until_sample = sweep;
+	while(1){
+		if(iterations >= t->check_at && trial_check(t, iterations, 0)){
+			break;
 		}
-		if(started_same == 0 && X[v_x][v_y] != Y[v_x][v_y]){
-			global_diff_count += 1;
+		iterations += 1;
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
+		if(rng_double(&t->stream) <= occupation_prob){
+			//occupy only if no neighbor is occupied
+			if(!X[v_x][v_y] && !X[(v_x + 1) % n][v_y] && !X[(v_x + n - 1) % n][v_y]
+				&& !X[v_x][(v_y + 1) % n] && !X[v_x][(v_y + n - 1) % n]){
+				X[v_x][v_y] = 1;
+				occupied++;
+			}
+		}
+		else if(X[v_x][v_y]){
+			X[v_x][v_y] = 0;
+			occupied--;
 		}
-		else if(started_same != 0 && X[v_x][v_y] == Y[v_x][v_y]){
-			global_diff_count -= 1;
+		if(--until_sample == 0){
+			until_sample = sweep;
+			series_push(&obs[0], occupied / (double)sweep);
 		}
 	}
 	return iterations;
-}
\ No newline at end of file
+}
@@ -2,72 +2,57 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include "../common/sweep.h"
 
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double beta, trial *t);
+unsigned long long relax_chain(int n, double alpha, trial *t, series *obs);
+unsigned long long leap_chains(long long n, double alpha, double eps, trial *t);
 
-void simulation(int n, int k, double a_low, double a_high, double a_step);
-int mix_chains(int n, double beta);
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * Note that here alpha/n is used in the partition function,
+ * this is also referred to as beta/n. -L eps runs leap_chains instead, for n up to 10^10 and beyond
+ */
+const model model_entry = {
+	.name = "curie-weiss",
+	.prefix = "curie-weiss-heat-bath",
+	.results = "results/curie-weiss-heat-bath:%lld:%d:%f:%f:%f:%llu",
+	.param = "alpha",
+	.version = &engine_version,
+	.mix = mix_chains,
+	.relax = relax_chain,
+	.observables = 1,
+	.observable = {"magnetization"},
+	.leap = leap_chains,
+};
 
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
 /**
  * Main method wrapper
  * @param  argc the number of arguments
  * @param  argv the arguments array
- * @return      not used
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, a_low, a_high, a_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double a_low = atof(argv[3]);
-	double a_high = atof(argv[4]);
-	double a_step = atof(argv[5]);
-	simulation(n, k, a_low, a_high, a_step);
-
-}
-
-/**
- * Run the simulation with the specified parameters. Note that here alpha/n is used in the partition function,
- * this is also referred to as beta/n
- * @param n      The size of the graph (complete graph) n= vertex count
- * @param k      The number of iterations for each alpha
- * @param a_low  The alpha to begin with
- * @param a_high The alpha to end with
- * @param a_step The alpha to step with 
- */
-void simulation(int n, int k, double a_low, double a_high, double a_step){
-	double alpha = a_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/curie-weiss-heat-bath:%d:%d:%f:%f:%f:%d", n, k, a_low, a_high, a_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	while(alpha <= a_high){
-		for(int i = 0; i < k; i++){
-			iterations = mix_chains(n, alpha);
-			fprintf(f, "%f %d\n", alpha, iterations);
-			printf("alpha: %f, k: %d, iterations: %d\n", alpha, i, iterations);
-		}
-		alpha += a_step;
-	}
-	fclose(f);
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
  * Run an all positive and all negative starting chains until they couple
  * and report the required number of iterations
  * @param  n     The size of the chains
  * @param  alpha The alpha for the partition function
+ * @param  t     The trial budget, set to censored if it runs out
  * @return       The iterations needed for mixing
  */
-int mix_chains(int n, double alpha){
+unsigned long long mix_chains(int n, double alpha, trial *t){
 	//we are on the graph K_n so we represent X and Y by two lists and counts for bookkeeping
-	int X[n];
-	int Y[n];
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	int *Y = pool_get(t->scratch, 1, n * sizeof(int));
 
 	for(int i = 0; i < n; i++){
 		X[i] = 1;
@@ -86,8 +71,11 @@ int mix_chains(int n, double alpha){
 
 	while (global_diff_count > 0){
 
+		if(iterations >= t->check_at && trial_check(t, iterations, global_diff_count)){
+			break;
+		}
 		iterations += 1;
-		v = arc4random_uniform(n);
+		v = rng_uniform(&t->stream, n);
 		started_same = X[v] - Y[v];
 
 		//calculate the probability of the vertex being positive with Glauber for both chains
@@ -111,7 +99,7 @@ int mix_chains(int n, double alpha){
 
 		X_pos_prob = exp(alpha / n * spin_sum) / (exp(alpha / n * spin_sum) + exp(-1 * alpha / n * spin_sum));
 
-		r = ((double)arc4random() / ARC4RANDOM_MAX);
+		r = rng_double(&t->stream);
 		
 		if (r <= Y_pos_prob){
 			if(Y[v] != 1){
@@ -147,4 +135,275 @@ int mix_chains(int n, double alpha){
 	}
 
 	return iterations;
-}
\ No newline at end of file
+}
+
+/**
+ * Run the all positive chain alone for the trial's step budget and record its magnetization
+ * once every sweep (n steps), for the single long run autocorrelation estimator
+ * @param  n     The size of the chain
+ * @param  alpha The alpha for the partition function
+ * @param  t     The trial, its step budget is the length of the run
+ * @param  obs   The magnetization series
+ * @return       The iterations run
+ */
+unsigned long long relax_chain(int n, double alpha, trial *t, series *obs){
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	for(int i = 0; i < n; i++){
+		X[i] = 1;
+	}
+	int X_pos_total = n;
+	unsigned long long iterations = 0;
+	int v, spin_sum;
+	double X_pos_prob;
+
+	unsigned long long until_sample = n;
+	while(1){
+		if(iterations >= t->check_at && trial_check(t, iterations, 0)){
+			break;
+		}
+		iterations += 1;
+		v = rng_uniform(&t->stream, n);
+		//the spin sum of the other vertexes
+		spin_sum = 2 * X_pos_total - n - X[v];
+		X_pos_prob = exp(alpha / n * spin_sum) / (exp(alpha / n * spin_sum) + exp(-1 * alpha / n * spin_sum));
+		if(rng_double(&t->stream) <= X_pos_prob){
+			if(X[v] != 1){
+				X_pos_total += 1;
+			}
+			X[v] = 1;
+		}
+		else{
+			if(X[v] == 1){
+				X_pos_total -= 1;
+			}
+			X[v] = -1;
+		}
+		if(--until_sample == 0){
+			until_sample = n;
+			series_push(&obs[0], (2 * X_pos_total - n) / (double)n);
+		}
+	}
+	return iterations;
+}
+
+//the three kinds of vertexes of the coupled chains: + in both, + in X and - in Y, - in both. The heat bath
+//coupling is monotone, so started at X all + and Y all - a vertex is never - in X and + in Y
+#define LEAP_PP 0
+#define LEAP_PM 1
+#define LEAP_MM 2
+//leaps shorter than this many steps are replaced by exact steps
+#define LEAP_MIN 16
+
+/**
+ * Poisson random variable, by inversion for small means and by Hormann's transformed rejection (PTRS)
+ * otherwise
+ * @param  r    The generator
+ * @param  mean The mean
+ * @return      The sample
+ */
+static double leap_poisson(rng *r, double mean){
+	if(mean <= 0){
+		return 0;
+	}
+	if(mean < 12){
+		double limit = exp(-mean), prod = rng_double(r);
+		double k = 0;
+		while(prod > limit){
+			k++;
+			prod *= rng_double(r);
+		}
+		return k;
+	}
+	double slam = sqrt(mean), loglam = log(mean);
+	double b = 0.931 + 2.53 * slam;
+	double a = -0.059 + 0.02483 * b;
+	double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+	double vr = 0.9277 - 3.6224 / (b - 2);
+	while(1){
+		double u = rng_double(r) - 0.5;
+		double v = rng_double(r);
+		double us = 0.5 - fabs(u);
+		double k = floor((2 * a / us + b) * u + mean + 0.43);
+		if(us >= 0.07 && v <= vr){
+			return k;
+		}
+		if(k < 0 || (us < 0.013 && v > us)){
+			continue;
+		}
+		if(log(v) + log(invalpha) - log(a / (us * us) + b) <= -mean + k * loglam - lgamma(k + 1)){
+			return k;
+		}
+	}
+}
+
+/**
+ * Probability that a vertex of each kind moves to each kind in one step, given the vertex is chosen:
+ * it ends + in Y (and so in X) if r <= the Y probability, + in X only if r <= the X probability
+ * @param n     The number of vertexes
+ * @param alpha The alpha for the partition function
+ * @param count The number of vertexes of each kind
+ * @param move  Set to move[from][to]
+ */
+static void leap_moves(long long n, double alpha, const double count[3], double move[3][3]){
+	double X_pos_total = count[LEAP_PP] + count[LEAP_PM], Y_pos_total = count[LEAP_PP];
+	//the spin of the chosen vertex in X and Y for each kind
+	static const int x_spin[3] = {1, 1, -1}, y_spin[3] = {1, -1, -1};
+	for(int from = 0; from < 3; from++){
+		double X_sum = 2 * X_pos_total - n - x_spin[from];
+		double Y_sum = 2 * Y_pos_total - n - y_spin[from];
+		double X_pos_prob = 1 / (1 + exp(-2 * alpha / n * X_sum));
+		double Y_pos_prob = 1 / (1 + exp(-2 * alpha / n * Y_sum));
+		move[from][LEAP_PP] = Y_pos_prob;
+		move[from][LEAP_PM] = X_pos_prob - Y_pos_prob;
+		move[from][LEAP_MM] = 1 - X_pos_prob;
+	}
+}
+
+/**
+ * Largest leap, in steps, over which the expected change of every kind's count stays within
+ * max(eps * count, 1) and so does its standard deviation (Cao, Gillespie and Petzold's step selection)
+ * @param  count The number of vertexes of each kind
+ * @param  rate  rate[from][to], the expected from -> to moves per step
+ * @param  eps   The error tolerance
+ * @return       The leap
+ */
+static double leap_size(const double count[3], double rate[3][3], double eps){
+	double leap = INFINITY;
+	for(int s = 0; s < 3; s++){
+		double drift = 0, spread = 0;
+		for(int o = 0; o < 3; o++){
+			if(o != s){
+				drift += rate[o][s] - rate[s][o];
+				spread += rate[o][s] + rate[s][o];
+			}
+		}
+		double bound = fmax(eps * count[s], 1);
+		if(drift != 0){
+			leap = fmin(leap, bound / fabs(drift));
+		}
+		if(spread > 0){
+			leap = fmin(leap, bound * bound / spread);
+		}
+	}
+	return floor(leap);
+}
+
+/**
+ * Approximate coupling time of the chains of mix_chains for very large n. Only the numbers of vertexes of
+ * each kind are kept. While many vertexes disagree the chains advance in leaps of many steps with Poisson
+ * numbers of moves between kinds, the leap bounded by eps. Once fewer than 1 / eps disagree the steps that
+ * choose a disagreeing vertex or create one are simulated exactly, jumping the geometric gaps between them,
+ * and only the agreeing bulk leaps
+ * @param  n     The number of vertexes
+ * @param  alpha The alpha for the partition function
+ * @param  eps   The error tolerance of a leap, e.g. 0.01
+ * @param  t     The trial budget, set to censored if it runs out
+ * @return       The iterations needed for mixing
+ */
+unsigned long long leap_chains(long long n, double alpha, double eps, trial *t){
+	double count[3] = {0, (double)n, 0};
+	double move[3][3], rate[3][3];
+	unsigned long long iterations = 0;
+
+	while(count[LEAP_PM] > 0){
+		if(iterations >= t->check_at && trial_check(t, iterations, (long long)count[LEAP_PM])){
+			break;
+		}
+		//steps left before the next check, leaps never cross it so budgets stay exact
+		double room = (double)(t->check_at - iterations);
+		leap_moves(n, alpha, count, move);
+
+		if(count[LEAP_PM] * eps >= 1){
+			for(int from = 0; from < 3; from++){
+				for(int to = 0; to < 3; to++){
+					rate[from][to] = from == to ? 0 : count[from] / n * move[from][to];
+				}
+			}
+			double leap = fmin(leap_size(count, rate, eps), room);
+			double flow[3][3] = {{0}};
+			int valid = 0;
+			while(leap >= LEAP_MIN && !valid){
+				valid = 1;
+				for(int from = 0; from < 3; from++){
+					double out = 0;
+					for(int to = 0; to < 3; to++){
+						flow[from][to] = from == to ? 0 : leap_poisson(&t->stream, leap * rate[from][to]);
+						out += flow[from][to];
+					}
+					//a leap that moves more vertexes than a kind has is retried at half the size
+					if(out > count[from]){
+						valid = 0;
+					}
+				}
+				if(!valid){
+					leap = floor(leap / 2);
+				}
+			}
+			if(valid){
+				for(int from = 0; from < 3; from++){
+					for(int to = 0; to < 3; to++){
+						count[from] -= flow[from][to];
+						count[to] += flow[from][to];
+					}
+				}
+				iterations += (unsigned long long)leap;
+				continue;
+			}
+		}
+		else{
+			//the per step chance of choosing a disagreeing vertex or making an agreeing one disagree
+			double event = count[LEAP_PM] / n + count[LEAP_PP] / n * move[LEAP_PP][LEAP_PM]
+				+ count[LEAP_MM] / n * move[LEAP_MM][LEAP_PM];
+			double gap = event >= 1 ? 1 : 1 + floor(log(1 - rng_double(&t->stream)) / log1p(-event));
+			//the agreeing vertexes move between + and - in the steps before the event, conditioned on no event
+			double bulk = fmin(gap - 1, room);
+			while(bulk > 0){
+				for(int from = 0; from < 3; from++){
+					for(int to = 0; to < 3; to++){
+						rate[from][to] = 0;
+					}
+				}
+				rate[LEAP_PP][LEAP_MM] = count[LEAP_PP] / n * move[LEAP_PP][LEAP_MM] / (1 - event);
+				rate[LEAP_MM][LEAP_PP] = count[LEAP_MM] / n * move[LEAP_MM][LEAP_PP] / (1 - event);
+				double leap = fmax(fmin(leap_size(count, rate, eps), bulk), 1);
+				double down = fmin(leap_poisson(&t->stream, leap * rate[LEAP_PP][LEAP_MM]), count[LEAP_PP]);
+				double up = fmin(leap_poisson(&t->stream, leap * rate[LEAP_MM][LEAP_PP]), count[LEAP_MM]);
+				count[LEAP_PP] += up - down;
+				count[LEAP_MM] += down - up;
+				iterations += (unsigned long long)leap;
+				bulk -= leap;
+				leap_moves(n, alpha, count, move);
+			}
+			if(gap - 1 >= room){
+				continue;
+			}
+			//the event step itself is exact
+			iterations += 1;
+			double pick = rng_double(&t->stream) * (count[LEAP_PM] + count[LEAP_PP] * move[LEAP_PP][LEAP_PM]
+				+ count[LEAP_MM] * move[LEAP_MM][LEAP_PM]);
+			if(pick < count[LEAP_PM]){
+				double r = rng_double(&t->stream);
+				int to = r <= move[LEAP_PM][LEAP_PP] ? LEAP_PP : r <= move[LEAP_PM][LEAP_PP] + move[LEAP_PM][LEAP_PM] ? LEAP_PM : LEAP_MM;
+				count[LEAP_PM]--;
+				count[to]++;
+			}
+			else{
+				int from = pick < count[LEAP_PM] + count[LEAP_PP] * move[LEAP_PP][LEAP_PM] ? LEAP_PP : LEAP_MM;
+				count[from]--;
+				count[LEAP_PM]++;
+			}
+			continue;
+		}
+
+		//too few steps to leap over, take one exact step
+		iterations += 1;
+		double u = rng_double(&t->stream) * n;
+		int from = u < count[LEAP_PP] ? LEAP_PP : u < count[LEAP_PP] + count[LEAP_PM] ? LEAP_PM : LEAP_MM;
+		double r = rng_double(&t->stream);
+		int to = r <= move[from][LEAP_PP] ? LEAP_PP : r <= move[from][LEAP_PP] + move[from][LEAP_PM] ? LEAP_PM : LEAP_MM;
+		count[from]--;
+		count[to]++;
+	}
+
+	return iterations;
+}
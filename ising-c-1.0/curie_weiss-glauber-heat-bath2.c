@@ -2,72 +2,55 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include "../common/sweep.h"
 
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double beta, trial *t);
+unsigned long long relax_chain(int n, double alpha, trial *t, series *obs);
 
-void simulation(int n, int k, double a_low, double a_high, double a_step);
-int mix_chains(int n, double beta);
-
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * Note that here alpha/n is used in the partition function,
+ * this is also referred to as beta/n
+ */
+const model model_entry = {
+	.name = "curie-weiss-totals",
+	.prefix = "curie-weiss-heat-bath",
+	.results = "results/curie-weiss-heat-bath:%lld:%d:%f:%f:%f:%llu",
+	.param = "alpha",
+	.version = &engine_version,
+	.mix = mix_chains,
+	.relax = relax_chain,
+	.observables = 1,
+	.observable = {"magnetization"},
+};
+
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
 /**
  * Main method wrapper
  * @param  argc the number of arguments
  * @param  argv the arguments array
- * @return      not used
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, a_low, a_high, a_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double a_low = atof(argv[3]);
-	double a_high = atof(argv[4]);
-	double a_step = atof(argv[5]);
-	simulation(n, k, a_low, a_high, a_step);
-
-}
-
-/**
- * Run the simulation with the specified parameters. Note that here alpha/n is used in the partition function,
- * this is also referred to as beta/n
- * @param n      The size of the graph (complete graph) n= vertex count
- * @param k      The number of iterations for each alpha
- * @param a_low  The alpha to begin with
- * @param a_high The alpha to end with
- * @param a_step The alpha to step with 
- */
-void simulation(int n, int k, double a_low, double a_high, double a_step){
-	double alpha = a_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/curie-weiss-heat-bath:%d:%d:%f:%f:%f:%d", n, k, a_low, a_high, a_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	while(alpha <= a_high){
-		for(int i = 0; i < k; i++){
-			iterations = mix_chains(n, alpha);
-			fprintf(f, "%f %d\n", alpha, iterations);
-			printf("alpha: %f, k: %d, iterations: %d\n", alpha, i, iterations);
-		}
-		alpha += a_step;
-	}
-	fclose(f);
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
  * Run an all positive and all negative starting chains until they couple
  * and report the required number of iterations
  * @param  n     The size of the chains
  * @param  alpha The alpha for the partition function
+ * @param  t     The trial budget, set to censored if it runs out
  * @return       The iterations needed for mixing
  */
-int mix_chains(int n, double alpha){
+unsigned long long mix_chains(int n, double alpha, trial *t){
 	//we are on the graph K_n so we represent X and Y by two lists and counts for bookkeeping
-	int X[n];
-	int Y[n];
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	int *Y = pool_get(t->scratch, 1, n * sizeof(int));
 
 	for(int i = 0; i < n; i++){
 		X[i] = 1;
@@ -86,8 +69,11 @@ int mix_chains(int n, double alpha){
 
 	while (X_pos_total != Y_pos_total){
 
+		if(iterations >= t->check_at && trial_check(t, iterations, global_diff_count)){
+			break;
+		}
 		iterations += 1;
-		v = arc4random_uniform(n);
+		v = rng_uniform(&t->stream, n);
 		started_same = X[v] - Y[v];
 
 		//calculate the probability of the vertex being positive with Glauber for both chains
@@ -111,7 +97,7 @@ int mix_chains(int n, double alpha){
 
 		X_pos_prob = exp(alpha / n * spin_sum) / (exp(alpha / n * spin_sum) + exp(-1 * alpha / n * spin_sum));
 
-		r = ((double)arc4random() / ARC4RANDOM_MAX);
+		r = rng_double(&t->stream);
 		
 		if (r <= Y_pos_prob){
 			if(Y[v] != 1){
@@ -147,4 +133,53 @@ int mix_chains(int n, double alpha){
 	}
 
 	return iterations;
-}
\ No newline at end of file
+}
+
+/**
+ * Run the all positive chain alone for the trial's step budget and record its magnetization
+ * once every sweep (n steps), for the single long run autocorrelation estimator
+ * @param  n     The size of the chain
+ * @param  alpha The alpha for the partition function
+ * @param  t     The trial, its step budget is the length of the run
+ * @param  obs   The magnetization series
+ * @return       The iterations run
+ */
+unsigned long long relax_chain(int n, double alpha, trial *t, series *obs){
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	for(int i = 0; i < n; i++){
+		X[i] = 1;
+	}
+	int X_pos_total = n;
+	unsigned long long iterations = 0;
+	int v, spin_sum;
+	double X_pos_prob;
+
+	unsigned long long until_sample = n;
+	while(1){
+		if(iterations >= t->check_at && trial_check(t, iterations, 0)){
+			break;
+		}
+		iterations += 1;
+		v = rng_uniform(&t->stream, n);
+		//the spin sum of the other vertexes
+		spin_sum = 2 * X_pos_total - n - X[v];
+		X_pos_prob = exp(alpha / n * spin_sum) / (exp(alpha / n * spin_sum) + exp(-1 * alpha / n * spin_sum));
+		if(rng_double(&t->stream) <= X_pos_prob){
+			if(X[v] != 1){
+				X_pos_total += 1;
+			}
+			X[v] = 1;
+		}
+		else{
+			if(X[v] == 1){
+				X_pos_total -= 1;
+			}
+			X[v] = -1;
+		}
+		if(--until_sample == 0){
+			until_sample = n;
+			series_push(&obs[0], (2 * X_pos_total - n) / (double)n);
+		}
+	}
+	return iterations;
+}
@@ -2,171 +2,535 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../common/sweep.h"
 
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double beta, trial *t);
+unsigned long long mix_chains_counts(int n, double beta, trial *t);
+unsigned long long mix_chains_parallel(int n, double beta, trial *t);
+unsigned long long relax_chain(int n, double beta, trial *t, series *obs);
 
-void simulation(int n, int k, double b_low, double b_high, double b_step);
-int mix_chains(int n, double beta);
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * cc -DNEIGHBOR_COUNTS runs mix_chains_counts, which draws the same trials
+ */
+const model model_entry = {
+	.name = "torus",
+	.prefix = "tours-heat-bath",
+	.results = "results/tours-heat-bath:%lld:%d:%f:%f:%f:%llu",
+	.param = "beta",
+	.torus = 1,
+	.version = &engine_version,
+#ifdef NEIGHBOR_COUNTS
+	.mix = mix_chains_counts,
+#else
+	.mix = mix_chains,
+#endif
+	.relax = relax_chain,
+	.observables = 2,
+	.observable = {"magnetization", "energy"},
+	.snapshots = 1,
+	.parallel = mix_chains_parallel,
+};
 
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
 /**
  * Main method wrapper
- * @param  argc number of args
- * @param  argv arguments array
- * @return      not used
+ * @param  argc the number of arguments
+ * @param  argv the arguments array
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, b_low, b_high, b_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double b_low = atof(argv[3]);
-	double b_high = atof(argv[4]);
-	double b_step = atof(argv[5]);
-	simulation(n, k, b_low, b_high, b_step);
-
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
- * Run the simulation with the specified paramters
- * @param n      The size of the torus
- * @param k      The number of trials to run for each beta
- * @param b_low  The beta to start at
- * @param b_high The beta to end at
- * @param b_step The increment for beta
+ * Run the chains X and Y until they couple
+ * @param  n    The size of the 2D torus
+ * @param  beta The value for beta for the partition function
+ * @param  t    The trial budget, set to censored if it runs out
+ * @return      The iterations required for coupling
  */
-void simulation(int n, int k, double b_low, double b_high, double b_step){
-	double beta = b_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/tours-heat-bath:%d:%d:%f:%f:%f:%d", n, k, b_low, b_high, b_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	while(beta <= b_high){
-		for(int i = 0; i < k; i++){
-			iterations = mix_chains(n, beta);
-			fprintf(f, "%f %d\n", beta, iterations);
-			printf("beta: %f, k: %d, iterations: %d\n", beta, i, iterations);
-		}
-		beta += b_step;
-	}
-	fclose(f);
+unsigned long long mix_chains(int n, double beta, trial *t){
+	//X and Y of a site share one byte, bit 0 set when X is + and bit 1 when Y is +, so one gather of the
+	//4 neighbors serves both chains and a site disagrees exactly when its two bits differ
+	//the lattice comes from the scratch pool so it is reused across trials instead of living on the stack
+	uint8_t (*S)[n] = pool_get(t->scratch, 0, (size_t)n * n);
+	unsigned long long iterations = 0;
+	//start X at all + and Y at all -
+	int global_diff_count = n * n;
+	memset(S, 1, (size_t)n * n);
+
+	//heat bath probability of + by the number of + neighbors, the local spin sum is 2 * up - 4
+	double pos_prob[5];
+	for(int up = 0; up <= 4; up++){
+		int local_spin_sum = 2 * up - 4;
+		pos_prob[up] = exp(beta * local_spin_sum) / (exp(beta * local_spin_sum ) + exp(-1 * beta * local_spin_sum));
+	}
+	//spreads a site's two bits into two nibbles, so adding the neighbors counts + spins of X in the low
+	//nibble and of Y in the high nibble at once
+	static const int spread[4] = {0x00, 0x01, 0x10, 0x11};
+
+	int v_x, v_y, up, down, left, right, counts;
+	uint8_t old, now;
+	double r;
+
+	while(global_diff_count > 0){
+		if(iterations >= t->check_at){
+			//snapshots share the check point so the hot loop keeps a single comparison
+			if(iterations >= t->snap_at){
+				snapshot_take(t, iterations, global_diff_count, &S[0][0], 0);
+			}
+			if(trial_check(t, iterations, global_diff_count)){
+				break;
+			}
+		}
+		iterations += 1;
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
+
+		//neighbors with wrap around
+		up = v_x == 0 ? n - 1 : v_x - 1;
+		down = v_x == n - 1 ? 0 : v_x + 1;
+		left = v_y == 0 ? n - 1 : v_y - 1;
+		right = v_y == n - 1 ? 0 : v_y + 1;
+		counts = spread[S[down][v_y]] + spread[S[up][v_y]] + spread[S[v_x][right]] + spread[S[v_x][left]];
+
+		r = rng_double(&t->stream);
+
+		//update both chains with the same r using glauber dynamics
+		old = S[v_x][v_y];
+		now = (r <= pos_prob[counts & 0xf]) | (r <= pos_prob[counts >> 4]) << 1;
+		S[v_x][v_y] = now;
+
+		//keep track of how many vertexes are different
+		global_diff_count += ((now ^ now >> 1) & 1) - ((old ^ old >> 1) & 1);
+	}
+	//the last frame, coupled or censored, is never dropped
+	if(t->snap != NULL){
+		snapshot_take(t, iterations, global_diff_count, &S[0][0], 1);
+	}
+
+	return iterations;
+
 }
 
 /**
- * Run the chains X and Y until they couple
+ * The chains of mix_chains, with each site's byte also holding its number of + neighbors in X (bits 2 - 4)
+ * and in Y (bits 5 - 7). The counts change only when a neighbor flips, so they are updated on flips and a
+ * step that flips nothing reads the one byte of its site. Same draws and same moves as mix_chains, so
+ * the trials and cached results are the same. It pays once the lattice outgrows the cache, about 5% at
+ * n = 1448 and 20% at n = 2048; a lattice that fits is faster to gather from than to keep counts for
  * @param  n    The size of the 2D torus
  * @param  beta The value for beta for the partition function
- * @param  X    Pointer for the X chain
- * @param  Y    Pointer for the Y chain
+ * @param  t    The trial budget, set to censored if it runs out
  * @return      The iterations required for coupling
  */
-int mix_chains(int n, double beta){
-	int X[n][n];
-	int Y[n][n];
+unsigned long long mix_chains_counts(int n, double beta, trial *t){
+	uint8_t (*S)[n] = pool_get(t->scratch, 0, (size_t)n * n);
 	unsigned long long iterations = 0;
-	/**
-	 * use +1 / -1 for spins, stat X at all + and Y at all -
-	 */
-	
+	//start X at all + and Y at all -, every site has 4 + neighbors in X and none in Y
 	int global_diff_count = n * n;
-	for(int i = 0; i < n; i++){
-		for(int j = 0; j < n; j++){
-			X[i][j] = 1;
-			Y[i][j] = -1;
-		}
+	memset(S, 1 | 4 << 2, (size_t)n * n);
+
+	double pos_prob[8];
+	for(int up = 0; up <= 4; up++){
+		int local_spin_sum = 2 * up - 4;
+		pos_prob[up] = exp(beta * local_spin_sum) / (exp(beta * local_spin_sum ) + exp(-1 * beta * local_spin_sum));
 	}
+	//what a site's X and Y bits add to the counts of each of its neighbors
+	static const int count[4] = {0, 1 << 2, 1 << 5, 1 << 2 | 1 << 5};
 
-	int v_x, v_y, started_same, local_spin_sum,
-		v_x_new, v_y_new;
-	double Y_pos_prob, X_pos_prob, r;
+	int v_x, v_y, up, down, left, right, delta;
+	uint8_t cell, old, now;
+	double r;
 
 	while(global_diff_count > 0){
+		if(iterations >= t->check_at){
+			if(iterations >= t->snap_at){
+				snapshot_take(t, iterations, global_diff_count, &S[0][0], 0);
+			}
+			if(trial_check(t, iterations, global_diff_count)){
+				break;
+			}
+		}
 		iterations += 1;
-		v_x = arc4random_uniform(n);
-		v_y = arc4random_uniform(n);
-
-		started_same = X[v_x][v_y] - Y[v_x][v_y];
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
+		r = rng_double(&t->stream);
 
-		local_spin_sum = 0;
-		//sum the spins of the neighbors observing wrap around in the Y chain
-		v_x_new = (v_x + 1) % n;
-		v_y_new = v_y;
-		local_spin_sum += Y[v_x_new][v_y_new];
-		v_x_new = (v_x - 1) % n;
-		if(v_x_new < 0){
-			v_x_new += n;
+		cell = S[v_x][v_y];
+		old = cell & 3;
+		now = (r <= pos_prob[cell >> 2 & 7]) | (r <= pos_prob[cell >> 5]) << 1;
+		if(now == old){
+			continue;
 		}
-		local_spin_sum += Y[v_x_new][v_y_new];
+		S[v_x][v_y] = cell ^ old ^ now;
+		//the counts never leave 0 - 4, so adding the difference to the packed byte moves both at once
+		delta = count[now] - count[old];
+		up = v_x == 0 ? n - 1 : v_x - 1;
+		down = v_x == n - 1 ? 0 : v_x + 1;
+		left = v_y == 0 ? n - 1 : v_y - 1;
+		right = v_y == n - 1 ? 0 : v_y + 1;
+		S[down][v_y] += delta;
+		S[up][v_y] += delta;
+		S[v_x][right] += delta;
+		S[v_x][left] += delta;
+		global_diff_count += ((now ^ now >> 1) & 1) - ((old ^ old >> 1) & 1);
+	}
+	if(t->snap != NULL){
+		snapshot_take(t, iterations, global_diff_count, &S[0][0], 1);
+	}
 
-		v_x_new = v_x;
-		v_y_new = (v_y + 1) % n;
-		local_spin_sum += Y[v_x_new][v_y_new];
-		v_y_new = (v_y - 1) % n;
-		if(v_y_new < 0){
-			v_y_new += n;
-		}
-		local_spin_sum += Y[v_x_new][v_y_new];
+	return iterations;
+}
 
-		//calculate the probability using glauber dynamics for Y chain
-		Y_pos_prob = exp(beta * local_spin_sum) / (exp(beta * local_spin_sum ) + exp(-1 * beta * local_spin_sum) );
+//steps drawn and scheduled together by mix_chains_parallel
+#define TORUS_BLOCK (1 << 16)
 
+typedef struct torus_step{
+	int x;
+	int y;
+	//the last earlier step of the block at the site's vertical neighbor in another strip, -1 if none
+	int dep;
+	double r;
+} torus_step;
 
-		local_spin_sum = 0;
+typedef struct torus_parallel{
+	int n;
+	uint8_t *S;
+	const double *pos_prob;
+	//the block being run and the end of the segment of it to run
+	const torus_step *steps;
+	int buffer;
+	int end;
+	//the boundary rows by slot, the last step of the block done at each of their sites
+	atomic_int *done;
+	//the slot of each row, -1 for rows inside a strip
+	const int *row_slot;
+	pthread_barrier_t start;
+	pthread_barrier_t end_barrier;
+	int stop;
+} torus_parallel;
 
-		//sum the spins of the neighbors observing wrap around in the X chain
-		v_x_new = (v_x + 1) % n;
-		v_y_new = v_y;
-		local_spin_sum += X[v_x_new][v_y_new];
-		v_x_new = (v_x - 1) % n;
-		if(v_x_new < 0){
-			v_x_new += n;
-		}
-		local_spin_sum += X[v_x_new][v_y_new];
+//a site a step of the segment changed and the byte it held before, to take back steps past the coupling
+typedef struct torus_undo{
+	int step;
+	int site;
+	uint8_t old;
+} torus_undo;
+
+typedef struct torus_strip{
+	torus_parallel *p;
+	int first;
+	int last;
+	//the strip's steps of each of the two blocks, in order, and how many of the running block are done
+	int *list[2];
+	int count[2];
+	int pos;
+	//the change in disagreement over a segment and its last step that changed it
+	long long delta;
+	int changed;
+	//the sites the strip's steps of the segment changed, in order
+	torus_undo *undo;
+	int undos;
+} torus_strip;
 
-		v_x_new = v_x;
-		v_y_new = (v_y + 1) % n;
-		local_spin_sum += X[v_x_new][v_y_new];
-		v_y_new = (v_y - 1) % n;
-		if(v_y_new < 0){
-			v_y_new += n;
+/**
+ * Run one strip's steps of the current segment. A step on the first or last row waits for the last earlier
+ * step at its neighbor across the boundary, which is the only other strip's step it could see or be seen by
+ * @param st The strip
+ */
+static void torus_strip_run(torus_strip *st){
+	torus_parallel *p = st->p;
+	int n = p->n;
+	uint8_t (*S)[n] = (uint8_t (*)[n])p->S;
+	const int *list = st->list[p->buffer];
+	int count = st->count[p->buffer];
+	static const int spread[4] = {0x00, 0x01, 0x10, 0x11};
+	int v_x, v_y, up, down, left, right, counts, slot, diff;
+	uint8_t old, now;
+	st->delta = 0;
+	st->changed = -1;
+	st->undos = 0;
+	for(; st->pos < count && list[st->pos] < p->end; st->pos++){
+		int j = list[st->pos];
+		const torus_step *sp = &p->steps[j];
+		v_x = sp->x;
+		v_y = sp->y;
+		up = v_x == 0 ? n - 1 : v_x - 1;
+		down = v_x == n - 1 ? 0 : v_x + 1;
+		left = v_y == 0 ? n - 1 : v_y - 1;
+		right = v_y == n - 1 ? 0 : v_y + 1;
+		if(sp->dep >= 0){
+			atomic_int *d = &p->done[p->row_slot[v_x == st->first ? up : down] * n + v_y];
+			while(atomic_load_explicit(d, memory_order_acquire) < sp->dep){
+				sched_yield();
+			}
+		}
+		counts = spread[S[down][v_y]] + spread[S[up][v_y]] + spread[S[v_x][right]] + spread[S[v_x][left]];
+		old = S[v_x][v_y];
+		now = (sp->r <= p->pos_prob[counts & 0xf]) | (sp->r <= p->pos_prob[counts >> 4]) << 1;
+		if(now != old){
+			S[v_x][v_y] = now;
+			st->undo[st->undos++] = (torus_undo){j, v_x * n + v_y, old};
+			diff = ((now ^ now >> 1) & 1) - ((old ^ old >> 1) & 1);
+			if(diff != 0){
+				st->delta += diff;
+				st->changed = j;
+			}
 		}
-		local_spin_sum += X[v_x_new][v_y_new];
+		slot = p->row_slot[v_x];
+		if(slot >= 0){
+			atomic_store_explicit(&p->done[slot * n + v_y], j, memory_order_release);
+		}
+	}
+}
 
+/**
+ * Worker of mix_chains_parallel, runs its strip of every segment until told to stop
+ * @param  arg The strip
+ * @return     not used
+ */
+static void *torus_strip_worker(void *arg){
+	torus_strip *st = arg;
+	while(1){
+		pthread_barrier_wait(&st->p->start);
+		if(st->p->stop){
+			return NULL;
+		}
+		torus_strip_run(st);
+		pthread_barrier_wait(&st->p->end_barrier);
+	}
+}
 
-		//calculate the probability using glauber dynamics for Y chain
-		X_pos_prob = exp(beta * local_spin_sum) / (exp(beta * local_spin_sum ) + exp(-1 * beta * local_spin_sum));
+/**
+ * Draw a block of steps from the trial's stream, in the order mix_chains draws them, and deal them to the
+ * strips, noting for each step next to a boundary the last earlier step across it
+ * @param st      The strips
+ * @param strips  The number of strips
+ * @param buffer  The block buffer to fill
+ * @param steps   The block
+ * @param n       The size of the torus
+ * @param strip_of The strip of each row
+ * @param row_slot The slot of each row, -1 for rows inside a strip
+ * @param last    Scratch, the last step of the block at each boundary site
+ * @param stream  The trial's stream
+ */
+static void torus_draw(torus_strip *st, int strips, int buffer, torus_step *steps, int n, const int *strip_of,
+		const int *row_slot, int *last, rng *stream){
+	for(int s = 0; s < strips; s++){
+		st[s].count[buffer] = 0;
+	}
+	for(int i = 0; i < 2 * strips * n; i++){
+		last[i] = -1;
+	}
+	for(int j = 0; j < TORUS_BLOCK; j++){
+		torus_step *sp = &steps[j];
+		sp->x = rng_uniform(stream, n);
+		sp->y = rng_uniform(stream, n);
+		sp->r = rng_double(stream);
+		int s = strip_of[sp->x];
+		sp->dep = -1;
+		if(strips > 1 && sp->x == st[s].first){
+			sp->dep = last[row_slot[sp->x == 0 ? n - 1 : sp->x - 1] * n + sp->y];
+		}
+		else if(strips > 1 && sp->x == st[s].last){
+			sp->dep = last[row_slot[sp->x == n - 1 ? 0 : sp->x + 1] * n + sp->y];
+		}
+		if(row_slot[sp->x] >= 0){
+			last[row_slot[sp->x] * n + sp->y] = j;
+		}
+		st[s].list[buffer][st[s].count[buffer]++] = j;
+	}
+}
 
+/**
+ * The chains of mix_chains with one trial's steps applied by t->threads threads, for lattices too large for
+ * one core. The torus is cut into strips of rows, one per thread. The calling thread draws blocks of steps
+ * from the trial's stream in the order mix_chains draws them, one block ahead, while the threads apply the
+ * previous block's steps of their strip in order; a step next to a boundary first waits for the last
+ * earlier step across it. Every step so sees the lattice it sees in mix_chains, and the iterations,
+ * budgets and snapshots are those of mix_chains for any thread count
+ * @param  n    The size of the 2D torus
+ * @param  beta The value for beta for the partition function
+ * @param  t    The trial budget, set to censored if it runs out
+ * @return      The iterations required for coupling
+ */
+unsigned long long mix_chains_parallel(int n, double beta, trial *t){
+	//strips of at least 2 rows, so a row borders at most one other strip
+	int strips = t->threads < n / 2 ? t->threads : n / 2;
+	if(strips < 1){
+		strips = 1;
+	}
+	torus_parallel p;
+	p.n = n;
+	p.S = pool_get(t->scratch, 0, (size_t)n * n);
+	torus_step *blocks = pool_get(t->scratch, 1, 2 * TORUS_BLOCK * sizeof(torus_step));
+	int *lists = pool_get(t->scratch, 2, (size_t)2 * strips * TORUS_BLOCK * sizeof(int));
+	p.done = pool_get(t->scratch, 3, (size_t)2 * strips * n * sizeof(atomic_int));
+	int *last = pool_get(t->scratch, 4, (size_t)2 * strips * n * sizeof(int));
+	int *row_slot = pool_get(t->scratch, 5, (size_t)n * 2 * sizeof(int));
+	int *strip_of = row_slot + n;
+	torus_undo *undo = pool_get(t->scratch, 6, (size_t)strips * TORUS_BLOCK * sizeof(torus_undo));
+	p.row_slot = row_slot;
+	p.stop = 0;
+	uint8_t (*S)[n] = (uint8_t (*)[n])p.S;
 
-		r = ((double)arc4random() / ARC4RANDOM_MAX);
-		
-		//update the chains with the proper probabilities 
-		if (r <= Y_pos_prob){
-			Y[v_x][v_y] = 1;
+	torus_strip st[strips];
+	for(int s = 0; s < strips; s++){
+		st[s].p = &p;
+		st[s].first = (int)((long long)n * s / strips);
+		st[s].last = (int)((long long)n * (s + 1) / strips) - 1;
+		st[s].list[0] = lists + (size_t)(2 * s) * TORUS_BLOCK;
+		st[s].list[1] = lists + (size_t)(2 * s + 1) * TORUS_BLOCK;
+		st[s].pos = 0;
+		st[s].undo = undo + (size_t)s * TORUS_BLOCK;
+		for(int row = st[s].first; row <= st[s].last; row++){
+			strip_of[row] = s;
+			row_slot[row] = strips == 1 ? -1 : row == st[s].first ? 2 * s : row == st[s].last ? 2 * s + 1 : -1;
 		}
-		else{
-			Y[v_x][v_y] = -1;
+	}
+
+	unsigned long long iterations = 0;
+	int global_diff_count = n * n;
+	memset(S, 1, (size_t)n * n);
+	double pos_prob[5];
+	for(int up = 0; up <= 4; up++){
+		int local_spin_sum = 2 * up - 4;
+		pos_prob[up] = exp(beta * local_spin_sum) / (exp(beta * local_spin_sum ) + exp(-1 * beta * local_spin_sum));
+	}
+	p.pos_prob = pos_prob;
+
+	pthread_barrier_init(&p.start, NULL, strips + 1);
+	pthread_barrier_init(&p.end_barrier, NULL, strips + 1);
+	pthread_t thread[strips];
+	for(int s = 0; s < strips; s++){
+		pthread_create(&thread[s], NULL, torus_strip_worker, &st[s]);
+	}
+
+	//the running block, how much of it is done, and whether the other buffer holds the next block
+	int buffer = 0, pos = 0, ahead = 0;
+	torus_draw(st, strips, buffer, blocks, n, strip_of, row_slot, last, &t->stream);
+	while(global_diff_count > 0){
+		if(iterations >= t->check_at){
+			if(iterations >= t->snap_at){
+				snapshot_take(t, iterations, global_diff_count, &S[0][0], 0);
+			}
+			if(trial_check(t, iterations, global_diff_count)){
+				break;
+			}
 		}
-		if (r <= X_pos_prob){
-			X[v_x][v_y] = 1;
+		if(pos == 0){
+			for(int i = 0; i < 2 * strips * n; i++){
+				atomic_store_explicit(&p.done[i], -1, memory_order_relaxed);
+			}
 		}
-		else{
-			X[v_x][v_y] = -1;
+		//segments end at check points, so budgets and snapshots fall where they do in mix_chains
+		p.steps = blocks + (size_t)buffer * TORUS_BLOCK;
+		p.buffer = buffer;
+		p.end = t->check_at - iterations < (unsigned long long)(TORUS_BLOCK - pos) ? pos + (int)(t->check_at - iterations) : TORUS_BLOCK;
+		pthread_barrier_wait(&p.start);
+		if(!ahead){
+			torus_draw(st, strips, 1 - buffer, blocks + (size_t)(1 - buffer) * TORUS_BLOCK, n, strip_of, row_slot, last, &t->stream);
+			ahead = 1;
 		}
+		pthread_barrier_wait(&p.end_barrier);
 
-		//keep track of how many vertexes are different
-		if (started_same == 0 && X[v_x][v_y] != Y[v_x][v_y]){
-			global_diff_count += 1;
+		int changed = -1;
+		for(int s = 0; s < strips; s++){
+			global_diff_count += st[s].delta;
+			changed = st[s].changed > changed ? st[s].changed : changed;
+		}
+		//once the chains agree they never part, so they coupled at the last step that changed the disagreement;
+		//the strips' steps past it are taken back, newest first, leaving the lattice mix_chains stops with
+		if(global_diff_count == 0){
+			for(int s = 0; s < strips; s++){
+				for(int u = st[s].undos - 1; u >= 0 && st[s].undo[u].step > changed; u--){
+					p.S[st[s].undo[u].site] = st[s].undo[u].old;
+				}
+			}
+		}
+		iterations += global_diff_count == 0 ? (unsigned long long)(changed + 1 - pos) : (unsigned long long)(p.end - pos);
+		pos = p.end;
+		if(pos == TORUS_BLOCK){
+			buffer = 1 - buffer;
+			pos = 0;
+			ahead = 0;
+			for(int s = 0; s < strips; s++){
+				st[s].pos = 0;
+			}
 		}
-		else if(started_same != 0 && X[v_x][v_y] == Y[v_x][v_y]){
-			global_diff_count -= 1;
-		}		
 	}
 
+	p.stop = 1;
+	pthread_barrier_wait(&p.start);
+	for(int s = 0; s < strips; s++){
+		pthread_join(thread[s], NULL);
+	}
+	pthread_barrier_destroy(&p.start);
+	pthread_barrier_destroy(&p.end_barrier);
+	if(t->snap != NULL){
+		snapshot_take(t, iterations, global_diff_count, &S[0][0], 1);
+	}
 
 	return iterations;
+}
 
-}
\ No newline at end of file
+/**
+ * Run the X chain alone from all + for the trial's step budget and record the magnetization and energy
+ * per site once every sweep (n * n steps), for the single long run autocorrelation estimator
+ * @param  n    The size of the 2D torus
+ * @param  beta The value for beta for the partition function
+ * @param  t    The trial, its step budget is the length of the run
+ * @param  obs  The magnetization and energy series
+ * @return      The iterations run
+ */
+unsigned long long relax_chain(int n, double beta, trial *t, series *obs){
+	int (*X)[n] = pool_get(t->scratch, 0, (size_t)n * n * sizeof(int));
+	unsigned long long iterations = 0, sweep = (unsigned long long)n * n;
+	long long magnetization = (long long)n * n;
+	long long energy = -2LL * n * n;
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j < n; j++){
+			X[i][j] = 1;
+		}
+	}
+	//the local spin sum is one of -4, -2, 0, 2, 4 so the heat bath probabilities are tabulated
+	double pos_prob[9];
+	for(int s = -4; s <= 4; s++){
+		pos_prob[s + 4] = exp(beta * s) / (exp(beta * s) + exp(-1 * beta * s));
+	}
+
+	int v_x, v_y, local_spin_sum, spin;
+	unsigned long long until_sample = sweep;
+	while(1){
+		if(iterations >= t->check_at && trial_check(t, iterations, 0)){
+			break;
+		}
+		iterations += 1;
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
+		local_spin_sum = X[(v_x + 1) % n][v_y] + X[(v_x + n - 1) % n][v_y]
+			+ X[v_x][(v_y + 1) % n] + X[v_x][(v_y + n - 1) % n];
+		spin = rng_double(&t->stream) <= pos_prob[local_spin_sum + 4] ? 1 : -1;
+		if(spin != X[v_x][v_y]){
+			magnetization += 2 * spin;
+			energy -= 2 * spin * local_spin_sum;
+			X[v_x][v_y] = spin;
+		}
+		if(--until_sample == 0){
+			until_sample = sweep;
+			series_push(&obs[0], magnetization / (double)sweep);
+			series_push(&obs[1], energy / (double)sweep);
+		}
+	}
+	return iterations;
+}
@@ -1,73 +1,61 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include "../common/sweep.h"
 
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double c, trial *t);
+unsigned long long relax_chain(int n, double c, trial *t, series *obs);
+unsigned long long cftp_chains(int n, double c, trial *t, long long *sample);
 
-void simulation(int n, int k, double c_low, double c_high, double c_step);
-int mix_chains(int n, double c);
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * Note that here c/n is used in the partition function,
+ * as the coupling constant
+ */
+const model model_entry = {
+	.name = "potts-glauber-metropolis",
+	.prefix = "glauber-metropolis",
+	.results = "results/glauber-metropolis-%lld-%d-%f-%f-%f-%llu",
+	.param = "c",
+	.version = &engine_version,
+	.mix = mix_chains,
+	.relax = relax_chain,
+	.observables = 3,
+	.observable = {"type0", "type1", "type2"},
+	.cftp = cftp_chains,
+	.spins = 3,
+};
 
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
 /**
  * Main method wrapper
  * @param  argc the number of arguments
  * @param  argv the arguments array
- * @return      not used
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, c_low, c_high, c_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double c_low = atof(argv[3]);
-	double c_high = atof(argv[4]);
-	double c_step = atof(argv[5]);
-	simulation(n, k, c_low, c_high, c_step);
-
-}
-
-/**
- * Run the simulation with the specified parameters. Note that here c/n is used in the partition function,
- * as the coupling constant
- * @param n      The size of the graph (complete graph) n= vertex count
- * @param k      The number of iterations for each c
- * @param c_low  The c to begin with
- * @param c_high The c to end with
- * @param c_step The c to step with 
- */
-void simulation(int n, int k, double c_low, double c_high, double c_step){
-	double c = c_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/glauber-metropolis-%d-%d-%f-%f-%f-%d", n, k, c_low, c_high, c_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	while(c <= c_high){
-		for(int i = 0; i < k; i++){
-			iterations = mix_chains(n, c);
-			fprintf(f, "%f %d\n", c, iterations);
-			printf("c: %f, k: %d, iterations: %d\n", c, i, iterations);
-		}
-		c += c_step;
-	}
-	fclose(f);
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
  * Run 3 chains (q=3) each starting at a configuration in which all of the vertexes have the same spin
  * @param  n     The size of the chains
  * @param  c The c for the partition function
+ * @param  t     The trial budget, set to censored if it runs out
  * @return       The iterations needed for mixing
  */
-int mix_chains(int n, double c){
+unsigned long long mix_chains(int n, double c, trial *t){
 	//we are on the graph K_n so we represent X, Y, Z by lists and type vectors
-	int X[n];
-	int Y[n];
-	int Z[n];
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	int *Y = pool_get(t->scratch, 1, n * sizeof(int));
+	int *Z = pool_get(t->scratch, 2, n * sizeof(int));
 	int X_type[3];
 	int Y_type[3];
 	int Z_type[3];
@@ -102,13 +90,23 @@ int mix_chains(int n, double c){
 				not_done = not_done | 1;
 			}
 		}
+		if(iterations >= t->check_at){
+			//report how far apart the type vectors still are
+			int type_diff = 0;
+			for(int i = 0; i < 3; i++){
+				type_diff += abs(X_type[i] - Y_type[i]) + abs(X_type[i] - Z_type[i]);
+			}
+			if(trial_check(t, iterations, type_diff)){
+				break;
+			}
+		}
 		iterations += 1;
-		v = arc4random_uniform(n);
-		new_spin = arc4random_uniform(3);
+		v = rng_uniform(&t->stream, n);
+		new_spin = rng_uniform(&t->stream, 3);
 
 		//make the move with the proper probability in each chain according to the metropolis rule		
 
-		r = ((double)arc4random() / ARC4RANDOM_MAX);
+		r = rng_double(&t->stream);
 
 		old_spin = X[v];
 		X_prob = X_type[new_spin] - (X_type[old_spin] - 1);
@@ -139,4 +137,153 @@ int mix_chains(int n, double c){
 	}
 
 	return iterations;
-}
\ No newline at end of file
+}
+
+/**
+ * Run the all 0 chain alone for the trial's step budget and record the fraction of vertexes in each
+ * spin class once every sweep (n steps), for the single long run autocorrelation estimator
+ * @param  n   The size of the chain
+ * @param  c   The c for the partition function
+ * @param  t   The trial, its step budget is the length of the run
+ * @param  obs The type vector series, one per spin
+ * @return     The iterations run
+ */
+unsigned long long relax_chain(int n, double c, trial *t, series *obs){
+	int *X = pool_get(t->scratch, 0, n * sizeof(int));
+	int X_type[3] = {n, 0, 0};
+	for(int i = 0; i < n; i++){
+		X[i] = 0;
+	}
+	unsigned long long iterations = 0;
+	int v, new_spin, old_spin;
+
+	unsigned long long until_sample = n;
+	while(1){
+		if(iterations >= t->check_at && trial_check(t, iterations, 0)){
+			break;
+		}
+		iterations += 1;
+		v = rng_uniform(&t->stream, n);
+		new_spin = rng_uniform(&t->stream, 3);
+		old_spin = X[v];
+		//metropolis rule as in mix_chains
+		if(rng_double(&t->stream) <= exp(c / n * (X_type[new_spin] - (X_type[old_spin] - 1)))){
+			X[v] = new_spin;
+			X_type[old_spin]--;
+			X_type[new_spin]++;
+		}
+		if(--until_sample == 0){
+			until_sample = n;
+			for(int i = 0; i < 3; i++){
+				series_push(&obs[i], X_type[i] / (double)n);
+			}
+		}
+	}
+	return iterations;
+}
+
+/**
+ * Coupling from the past with a bounding chain (Huber). Every vertex holds the mask of the spins it may have
+ * over all starts, and a step moves the masks so they still hold the spin of every start after it: for each
+ * spin the vertex may have, the Metropolis move is certainly taken, certainly not, or either, as the
+ * acceptance is above r, below it, or on both sides over the agreeing counts the masks allow. The counts
+ * only depend on how many vertexes hold each mask, kept in mask_type. The chain is started from all masks
+ * full at -1 sweep, -2 sweeps, -4 sweeps, ... and run to time 0, each block of steps drawn from its own
+ * stream so every restart replays the same moves, until every mask at time 0 is a single spin; that
+ * configuration is then an exact sample, whatever the chains started from.
+ * @param  n      The size of the chains
+ * @param  c      The c for the partition function
+ * @param  t      The trial budget, which counts the steps of every restart, set to censored if it runs out
+ * @param  sample Set to the number of vertexes at each spin of the exact sample
+ * @return        The steps from the start the masks coalesced from to time 0, within a factor 2 of the
+ *                least such start; for a censored trial, the largest start found not to coalesce
+ */
+unsigned long long cftp_chains(int n, double c, trial *t, long long *sample){
+	uint8_t *M = pool_get(t->scratch, 0, n);
+	//the vertexes holding each mask and, for each spin, those whose mask holds it
+	long long mask_type[8];
+	long long holding[3];
+	//the streams of the blocks of steps are keyed by their distance from time 0
+	uint64_t base = rng_next(&t->stream);
+	rng stream;
+
+	unsigned long long work = 0, failed = 0;
+	long long undecided = n;
+	int v, new_spin;
+	uint8_t old, now;
+	double r, low, high;
+	for(int restart = 0; ; restart++){
+		unsigned long long start = (unsigned long long)n << restart;
+		if(t->max_steps > 0 && work + start > t->max_steps){
+			t->censored = 1;
+			t->last_disagreement = undecided;
+			return failed;
+		}
+		memset(M, 7, n);
+		memset(mask_type, 0, sizeof(mask_type));
+		mask_type[7] = n;
+		holding[0] = holding[1] = holding[2] = n;
+		undecided = n;
+		//block 0 is the last sweep before time 0, block b > 0 the 2^(b - 1) sweeps before block b - 1
+		for(int b = restart; b >= 0; b--){
+			rng_seed(&stream, base, b);
+			unsigned long long steps = b == 0 ? (unsigned long long)n : (unsigned long long)n << (b - 1);
+			for(unsigned long long i = 0; i < steps; i++){
+				if(work >= t->check_at && trial_check(t, work, undecided)){
+					return failed;
+				}
+				work += 1;
+				v = rng_uniform(&stream, n);
+				new_spin = rng_uniform(&stream, 3);
+				r = rng_double(&stream);
+
+				old = M[v];
+				now = 0;
+				for(int o = 0; o < 3; o++){
+					if(!(old >> o & 1)){
+						continue;
+					}
+					if(o == new_spin){
+						now |= 1 << o;
+						continue;
+					}
+					//the other vertexes at new_spin less those at o, at least and at most
+					low = mask_type[1 << new_spin] - (holding[o] - 1);
+					high = holding[new_spin] - (old >> new_spin & 1) - (mask_type[1 << o] - (old == 1 << o));
+					low = exp(c / n * low);
+					high = exp(c / n * high);
+					if(c < 0){
+						double swap = low;
+						low = high;
+						high = swap;
+					}
+					if(r <= low){
+						now |= 1 << new_spin;
+					}
+					else if(r > high){
+						now |= 1 << o;
+					}
+					else{
+						now |= 1 << new_spin | 1 << o;
+					}
+				}
+				if(now != old){
+					M[v] = now;
+					mask_type[old]--;
+					mask_type[now]++;
+					for(int s = 0; s < 3; s++){
+						holding[s] += (now >> s & 1) - (old >> s & 1);
+					}
+					undecided += ((now & (now - 1)) != 0) - ((old & (old - 1)) != 0);
+				}
+			}
+		}
+		if(undecided == 0){
+			for(int s = 0; s < 3; s++){
+				sample[s] = mask_type[1 << s];
+			}
+			return start;
+		}
+		failed = start;
+	}
+}
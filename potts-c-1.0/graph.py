@@ -2,7 +2,46 @@ import matplotlib.pyplot as plt
 import sys
 
 def main():
-	make_custom_graph()
+	if len(sys.argv) > 1 and sys.argv[1] == "--survival":
+		make_survival_graph(sys.argv[2])
+	else:
+		make_custom_graph()
+
+def read_trials(file):
+	"""Read a results file into {param: [(iterations, censored)]}, censored lines
+	look like "param iterations censored last_disagreement"
+	"""
+	f = open(file, 'r')
+	d = {}
+	for line in f.readlines():
+		l = line.split()
+		censored = len(l) > 2 and l[2] == "censored"
+		d.setdefault(float(l[0]), []).append((int(l[1]), censored))
+	f.close()
+	return d
+
+def km_curve(trials):
+	"""Kaplan-Meier estimate of P(coupling time > t) as lists of times and survival values"""
+	trials = sorted(trials, key=lambda x: (x[0], x[1]))
+	at_risk = len(trials)
+	survival = 1.0
+	times = [0]
+	values = [1.0]
+	for (time, censored) in trials:
+		if not censored:
+			survival *= (at_risk - 1) / float(at_risk)
+			times.append(time)
+			values.append(survival)
+		at_risk -= 1
+	return times, values
+
+def km_median(trials):
+	"""Median of the Kaplan-Meier curve, None if censoring keeps it above 1/2"""
+	times, values = km_curve(trials)
+	for i in range(len(times)):
+		if values[i] <= 0.5:
+			return times[i]
+	return None
 
 def make_graph(file):
 	f = open(file, 'r')
@@ -33,25 +72,16 @@ def make_custom_graph():
 	files = sys.argv[1:]
 	file_map = {}
 	for file in files:
-		f = open(file, 'r')
-		lines = f.readlines()
-		d = {}
-		for line in lines:
-			l = line.split(" ")
-			if float(l[0]) in d.keys():
-				d[float(l[0])].append(int(l[1]))
-			else:
-				d[float(l[0])] = [int(l[1])]
+		d = read_trials(file)
 		x = []
 		y = []
-		keys = d.keys()
-		keys.sort()
-		for key in keys:
-			total = 0
-			for val in d[key]:
-				total += val
+		#budget capped trials are censored, so use the Kaplan-Meier median rather than the mean
+		for key in sorted(d.keys()):
+			median = km_median(d[key])
+			if median is None:
+				continue
 			x.append(key)
-			y.append(float(total) / len(d[key]))
+			y.append(median)
 		file_map[file] = (x,y)
 	for key in file_map.keys():
 		plt.plot(file_map[key][0], file_map[key][1], '-o', label=key.split(':')[0])
@@ -59,7 +89,17 @@ def make_custom_graph():
 	plt.legend(loc=2)
 	#plt.axis([0.38, 0.45, -100000, 85000000])
 	plt.xlabel("Beta")
-	plt.ylabel("Iterations")
+	plt.ylabel("Iterations (Kaplan-Meier median)")
+	plt.show()
+
+def make_survival_graph(file):
+	d = read_trials(file)
+	for key in sorted(d.keys()):
+		times, values = km_curve(d[key])
+		plt.step(times, values, where='post', label=str(key))
+	plt.legend(loc=1)
+	plt.xlabel("Iterations")
+	plt.ylabel("P(not coupled)")
 	plt.show()
 
 
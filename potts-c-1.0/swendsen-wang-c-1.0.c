@@ -2,84 +2,81 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define ARC4RANDOM_MAX      0x100000000
+#include "../common/sweep.h"
 
 typedef struct lnode{
 	struct lnode* next;
 	int val;
 } lnode;
 
-void simulation(int n, int k,  double c_low, double c_high, double c_step);
-int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** spin_array, lnode* stk, int* spin_counts);
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double c, trial *t);
+unsigned long long run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** spin_array, lnode* stk, int* spin_counts, trial *t);
 void llist_add(lnode* head, int val);
 int llist_pop(lnode* head);
 
 
 /**
- * Main method wrapper c
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * Note that here k=c/n is used in the partition function
+ */
+const model model_entry = {
+	.name = "swendsen-wang",
+	.prefix = "swendsen-wang",
+	.results = "results/swendsen-wang-%lld-3-%d-%f-%f-%f-%llu",
+	.param = "c",
+	.version = &engine_version,
+	.mix = mix_chains,
+};
+
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
+/**
+ * Main method wrapper
  * @param  argc the number of arguments
  * @param  argv the arguments array
- * @return      not used
+ * @return      0 on success
  */
 int main(int argc, char *argv[]){
-	if (argc != 6){
-		printf("Must supply n, k, c_low, c_high, c_step space delimited");
-	}
-	int n = atoi(argv[1]);
-	int k = atoi(argv[2]);
-	double c_low = atof(argv[3]);
-	double c_high = atof(argv[4]);
-	double c_step = atof(argv[5]);
-	simulation(n, k, c_low, c_high, c_step);
-
+	return sweep_main(argc, argv, &model_entry);
 }
+#endif
 
 /**
- * Run the simulation with the specified parameters. Note that here k=c/n is used in the partition function
- * @param n      The size of the graph (complete graph) n= vertex count
- * @param k      The number of iterations for each c
- * @param c_low  The c to begin with
- * @param c_high The c to end with
- * @param c_step The c to step with 
+ * Set up the per trial state for run_chain out of the scratch pool, so a sweep allocates it once
+ * rather than once per trial
+ * @param  n The number of vertexes
+ * @param  c The value of c in the coupling constant
+ * @param  t The trial budget, set to censored if it runs out
+ * @return   The number of iterations required to pass between the two type vectors
  */
-void simulation(int n, int k, double c_low, double c_high, double c_step){
+unsigned long long mix_chains(int n, double c, trial *t){
 	int q = 3;
-	double c = c_low;
-	int iterations;
-	char file_name[100];
-	sprintf(file_name, "results/swendsen-wang-%d-%d-%d-%f-%f-%f-%d", n, 3, k, c_low, c_high, c_step, (unsigned)time(NULL));
-	FILE *f = fopen(file_name, "w");
-	if(NULL == f){
-		printf("Error opening results file");
-		exit(1);
-	}
-	int** spin_assignments = malloc(2 * sizeof(int*));
-	int** visited = malloc(2 * sizeof(int*));
-	lnode*** spin_array = malloc(2 * sizeof(lnode**));
-	int* spin_counts = malloc(n * sizeof(int));
+	int* spin_assignments[2];
+	int* visited[2];
+	lnode** spin_array[2];
+	lnode* heads[2][3];
+	//sentinel heads for the 2 * q spin class lists and the dfs stack
+	lnode* sentinels = pool_get(t->scratch, 0, (2 * q + 1) * sizeof(lnode));
+	int* spin_counts = pool_get(t->scratch, 1, q * sizeof(int));
 	for(int i = 0; i < 2; i++){
-		spin_assignments[i] = malloc(n * sizeof(int));
-		visited[i] = malloc(n * sizeof(int));
-		spin_array[i] = malloc(q * sizeof(lnode*));
+		spin_assignments[i] = pool_get(t->scratch, 2 + i, n * sizeof(int));
+		visited[i] = pool_get(t->scratch, 4 + i, n * sizeof(int));
+		spin_array[i] = heads[i];
 		for(int j = 0; j < q; j++){
-			spin_array[i][j] = malloc(sizeof(lnode));
-			spin_array[i][j]->next = NULL;
-			spin_array[i][j]->val = -1; 
-			spin_counts[j] = 0;
+			heads[i][j] = &sentinels[i * q + j];
+			heads[i][j]->next = NULL;
+			heads[i][j]->val = -1;
 		}
 	}
-	lnode* stk = malloc(sizeof(lnode));
+	for(int j = 0; j < q; j++){
+		spin_counts[j] = 0;
+	}
+	lnode* stk = &sentinels[2 * q];
 	stk->next = NULL;
 	stk->val = -1;
-	while(c <= c_high){
-		for(int i = 0; i < k; i++){
-			iterations = run_chain(n, c, spin_assignments, visited, spin_array, stk, spin_counts);
-			fprintf(f, "%f %d\n", c, iterations);
-			printf("c: %f, k: %d, iterations: %d\n", c, i, iterations);
-		}
-		c += c_step;
-	}
-	fclose(f);
+	return run_chain(n, c, spin_assignments, visited, spin_array, stk, spin_counts, t);
 }
 
 /**
@@ -91,9 +88,10 @@ void simulation(int n, int k, double c_low, double c_high, double c_step){
  * @param  spin_array       2-d array of linked lists holding the vertexes within each spin class
  * @param  stk              stack pointer for the dfs
  * @param  spin_counts      int array for tracking the number of vertexes with each spin on this iteration
+ * @param  t                The trial budget, set to censored if it runs out
  * @return                  The number of iterations required to pass between the two type vectors
  */
-int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** spin_array, lnode* stk, int* spin_counts){
+unsigned long long run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** spin_array, lnode* stk, int* spin_counts, trial *t){
 	int q = 3;
 	int spin = 0, i = 0, j = 0, k = 0, current = 0, next = 1, equal_spin_count = 0, temp = 0, iterations = 0;
 	double p = 1 - exp(-1 * c / n);
@@ -115,6 +113,9 @@ int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** s
 	}
 
 	while(!(equal_spin_count == q)){
+		if(trial_check(t, iterations, q - equal_spin_count)){
+			break;
+		}
 		iterations++;
 		//for each spin class
 		for(i = 0; i < q; i++){
@@ -125,7 +126,7 @@ int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** s
 					continue;
 				}
 				//start the dfs for this new component, pick the spin at random
-				spin = arc4random_uniform(q);
+				spin = rng_uniform(&t->stream, q);
 				llist_add(stk, j);
 				while(stk->next != NULL){
 					j = llist_pop(stk);
@@ -141,7 +142,7 @@ int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** s
 					//for each edge push the neighbor on with the proper probability
 					for(k = 0; k < n; k++){
 						if(k != j && visited[current][k] == 0 && spin_assignments[current][j] == spin_assignments[current][k] 
-							&& ((double)arc4random() / ARC4RANDOM_MAX) <= p){
+							&& rng_double(&t->stream) <= p){
 							llist_add(stk, k);
 						}
 					}
@@ -171,13 +172,22 @@ int run_chain(int n, double c, int** spin_assignments, int** visited, lnode*** s
 	return iterations;
 }
 
+//popped nodes are kept here and handed out again by llist_add instead of going back to malloc
+static _Thread_local lnode* llist_free = NULL;
+
 /**
  * Add the given value to the front of the specified linked list
  * @param head The sentinel head node of the list
  * @param val  The value to add
  */
 void llist_add(lnode* head, int val){
-	lnode* new_node = malloc(sizeof(lnode));
+	lnode* new_node = llist_free;
+	if(new_node != NULL){
+		llist_free = new_node->next;
+	}
+	else{
+		new_node = malloc(sizeof(lnode));
+	}
 	new_node->val = val;
 	new_node->next = head->next;
 	head->next = new_node;
@@ -192,6 +202,7 @@ int llist_pop(lnode* head){
 	int ret = head->next->val;
 	lnode* ref = head->next;
 	head->next = head->next->next;
-	free(ref);
+	ref->next = llist_free;
+	llist_free = ref;
 	return ret;
 }
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../common/sweep.h"
+
+/**
+ * q state Potts Glauber-Metropolis coupling on the n x n torus, with Gibbs weight exp(c * number of
+ * agreeing edges) (c is the coupling itself here, there is no 1/n as on K_n; the transition is at
+ * c = log(1 + sqrt(q))). As glauber-metropolis.c does with X, Y, Z, the q chains started at all 0, ...,
+ * all q - 1 run together until they agree everywhere. q is fixed at compile time,
+ * cc -DPOTTS_Q=4 ..., default 3. Each chain's spin takes POTTS_BITS bits and the q spins of a site are
+ * packed into one word, so the lattice of all q chains is n * n bytes for q <= 4.
+ */
+#ifndef POTTS_Q
+#define POTTS_Q 3
+#endif
+//q as text, for the model's names
+#define POTTS_TEXT(q) #q
+#define POTTS_NAME_OF(q) POTTS_TEXT(q)
+#define POTTS_NAME POTTS_NAME_OF(POTTS_Q)
+//bits per spin, ceil(log2 q)
+#define POTTS_BITS (POTTS_Q <= 2 ? 1 : POTTS_Q <= 4 ? 2 : POTTS_Q <= 8 ? 3 : 4)
+#define POTTS_MASK ((1u << POTTS_BITS) - 1)
+#if POTTS_Q * POTTS_BITS <= 8
+typedef uint8_t potts_site;
+#elif POTTS_Q * POTTS_BITS <= 16
+typedef uint16_t potts_site;
+#elif POTTS_Q * POTTS_BITS <= 32
+typedef uint32_t potts_site;
+#elif POTTS_Q * POTTS_BITS <= 64
+typedef uint64_t potts_site;
+#else
+#error "POTTS_Q is too large to pack a site into one word"
+#endif
+//the spins a site may have in cftp_chains, bit j for spin j
+#if POTTS_Q <= 8
+typedef uint8_t potts_mask;
+#else
+typedef uint16_t potts_mask;
+#endif
+#define POTTS_FULL ((potts_mask)((1u << POTTS_Q) - 1))
+
+//bump when the kernel's output for a given seed changes, cached trials of older versions are then ignored
+const int engine_version = 1;
+unsigned long long mix_chains(int n, double c, trial *t);
+unsigned long long cftp_chains(int n, double c, trial *t, long long *sample);
+
+/**
+ * The model as the sweep (common/sweep.h) and the tools running several models (common/models.h) see it.
+ * The batch runner has the q = 3 build as potts-torus-q3
+ */
+const model model_entry = {
+	.name = "potts-torus-q" POTTS_NAME,
+	.prefix = "torus-glauber-metropolis-q" POTTS_NAME,
+	.results = "results/torus-glauber-metropolis-q" POTTS_NAME "-%lld-%d-%f-%f-%f-%llu",
+	.param = "c",
+	.torus = 1,
+	.version = &engine_version,
+	.mix = mix_chains,
+	.cftp = cftp_chains,
+	.spins = POTTS_Q,
+};
+
+//the tools running several models (common/models.h) include this file without its main
+#ifndef RUNNER
+/**
+ * Main method wrapper
+ * @param  argc the number of arguments
+ * @param  argv the arguments array
+ * @return      0 on success
+ */
+int main(int argc, char *argv[]){
+	return sweep_main(argc, argv, &model_entry);
+}
+#endif
+
+/**
+ * Run the q chains, chain j starting with every vertex at spin j, until they agree at every vertex
+ * @param  n The size of the torus
+ * @param  c The c for the partition function
+ * @param  t The trial budget, set to censored if it runs out
+ * @return   The iterations needed for mixing
+ */
+unsigned long long mix_chains(int n, double c, trial *t){
+	//chain j keeps its spin in bits j * POTTS_BITS of each site, one gather of the 4 neighbors serves all chains
+	//the lattice comes from the scratch pool so it is reused across trials instead of living on the stack
+	potts_site (*S)[n] = pool_get(t->scratch, 0, (size_t)n * n * sizeof(potts_site));
+	potts_site start = 0, ones = 0;
+	for(int j = 0; j < POTTS_Q; j++){
+		start |= (potts_site)j << (j * POTTS_BITS);
+		ones |= (potts_site)1 << (j * POTTS_BITS);
+	}
+	for(int i = 0; i < n; i++){
+		for(int j = 0; j < n; j++){
+			S[i][j] = start;
+		}
+	}
+	//the sites where the chains do not all agree
+	long long global_diff_count = (long long)n * n;
+
+	//metropolis acceptance by the change in agreeing neighbors, -4 ... 4
+	double accept[9];
+	for(int delta = -4; delta <= 4; delta++){
+		accept[delta + 4] = exp(c * delta);
+	}
+
+	unsigned long long iterations = 0;
+	int v_x, v_y, up, down, left, right, delta;
+	unsigned new_spin, old_spin, spin;
+	potts_site old, now, nb[4];
+	double r;
+
+	while(global_diff_count > 0){
+		if(iterations >= t->check_at && trial_check(t, iterations, global_diff_count)){
+			break;
+		}
+		iterations += 1;
+		v_x = rng_uniform(&t->stream, n);
+		v_y = rng_uniform(&t->stream, n);
+		new_spin = rng_uniform(&t->stream, POTTS_Q);
+
+		//make the move with the proper probability in each chain according to the metropolis rule
+		r = rng_double(&t->stream);
+
+		//neighbors with wrap around
+		up = v_x == 0 ? n - 1 : v_x - 1;
+		down = v_x == n - 1 ? 0 : v_x + 1;
+		left = v_y == 0 ? n - 1 : v_y - 1;
+		right = v_y == n - 1 ? 0 : v_y + 1;
+		nb[0] = S[down][v_y];
+		nb[1] = S[up][v_y];
+		nb[2] = S[v_x][right];
+		nb[3] = S[v_x][left];
+
+		old = S[v_x][v_y];
+		now = old;
+		for(int j = 0; j < POTTS_Q; j++){
+			int shift = j * POTTS_BITS;
+			old_spin = old >> shift & POTTS_MASK;
+			delta = 0;
+			for(int e = 0; e < 4; e++){
+				spin = nb[e] >> shift & POTTS_MASK;
+				delta += (spin == new_spin) - (spin == old_spin);
+			}
+			if(r <= accept[delta + 4]){
+				now = (now & ~((potts_site)POTTS_MASK << shift)) | (potts_site)new_spin << shift;
+			}
+		}
+		S[v_x][v_y] = now;
+
+		//a site agrees when every chain holds the spin of chain 0
+		global_diff_count += (now != (now & POTTS_MASK) * ones) - (old != (old & POTTS_MASK) * ones);
+	}
+
+	return iterations;
+}
+
+/**
+ * Coupling from the past with a bounding chain (Huber), as cftp_chains in glauber-metropolis.c does on K_n.
+ * Every site holds the mask of the spins it may have over all starts; for each spin the site may have, the
+ * Metropolis move is certainly taken, certainly not, or either, over the agreeing neighbors the 4
+ * neighboring masks allow. The chain is started from all masks full at -1 sweep, -2 sweeps, -4 sweeps, ...
+ * and run to time 0, replaying the same moves on every restart, until every mask at time 0 is a single spin
+ * @param  n      The size of the torus
+ * @param  c      The c for the partition function
+ * @param  t      The trial budget, which counts the steps of every restart, set to censored if it runs out
+ * @param  sample Set to the number of sites at each spin of the exact sample
+ * @return        The steps from the start the masks coalesced from to time 0, within a factor 2 of the
+ *                least such start; for a censored trial, the largest start found not to coalesce
+ */
+unsigned long long cftp_chains(int n, double c, trial *t, long long *sample){
+	potts_mask (*M)[n] = pool_get(t->scratch, 1, (size_t)n * n * sizeof(potts_mask));
+	//the streams of the blocks of steps are keyed by their distance from time 0
+	uint64_t base = rng_next(&t->stream);
+	rng stream;
+
+	//metropolis acceptance by the change in agreeing neighbors, -4 ... 4
+	double accept[9];
+	for(int delta = -4; delta <= 4; delta++){
+		accept[delta + 4] = exp(c * delta);
+	}
+
+	unsigned long long sweep = (unsigned long long)n * n, work = 0, failed = 0;
+	long long undecided = (long long)n * n;
+	int v_x, v_y, up, down, left, right, low, high;
+	unsigned new_spin;
+	potts_mask old, now, nb[4];
+	double r, accept_low, accept_high;
+	for(int restart = 0; ; restart++){
+		unsigned long long start = sweep << restart;
+		if(t->max_steps > 0 && work + start > t->max_steps){
+			t->censored = 1;
+			t->last_disagreement = undecided;
+			return failed;
+		}
+		for(int i = 0; i < n; i++){
+			for(int j = 0; j < n; j++){
+				M[i][j] = POTTS_FULL;
+			}
+		}
+		undecided = (long long)n * n;
+		//block 0 is the last sweep before time 0, block b > 0 the 2^(b - 1) sweeps before block b - 1
+		for(int b = restart; b >= 0; b--){
+			rng_seed(&stream, base, b);
+			unsigned long long steps = b == 0 ? sweep : sweep << (b - 1);
+			for(unsigned long long i = 0; i < steps; i++){
+				if(work >= t->check_at && trial_check(t, work, undecided)){
+					return failed;
+				}
+				work += 1;
+				v_x = rng_uniform(&stream, n);
+				v_y = rng_uniform(&stream, n);
+				new_spin = rng_uniform(&stream, POTTS_Q);
+				r = rng_double(&stream);
+
+				up = v_x == 0 ? n - 1 : v_x - 1;
+				down = v_x == n - 1 ? 0 : v_x + 1;
+				left = v_y == 0 ? n - 1 : v_y - 1;
+				right = v_y == n - 1 ? 0 : v_y + 1;
+				nb[0] = M[down][v_y];
+				nb[1] = M[up][v_y];
+				nb[2] = M[v_x][right];
+				nb[3] = M[v_x][left];
+
+				old = M[v_x][v_y];
+				now = 0;
+				for(unsigned o = 0; o < POTTS_Q; o++){
+					if(!(old >> o & 1)){
+						continue;
+					}
+					if(o == new_spin){
+						now |= 1u << o;
+						continue;
+					}
+					//the neighbors at new_spin less those at o, at least and at most
+					low = 0;
+					high = 0;
+					for(int e = 0; e < 4; e++){
+						low += (nb[e] == 1u << new_spin) - (nb[e] >> o & 1);
+						high += (nb[e] >> new_spin & 1) - (nb[e] == 1u << o);
+					}
+					accept_low = accept[(c < 0 ? high : low) + 4];
+					accept_high = accept[(c < 0 ? low : high) + 4];
+					if(r <= accept_low){
+						now |= 1u << new_spin;
+					}
+					else if(r > accept_high){
+						now |= 1u << o;
+					}
+					else{
+						now |= 1u << new_spin | 1u << o;
+					}
+				}
+				M[v_x][v_y] = now;
+				undecided += ((now & (now - 1)) != 0) - ((old & (old - 1)) != 0);
+			}
+		}
+		if(undecided == 0){
+			for(int s = 0; s < POTTS_Q; s++){
+				sample[s] = 0;
+			}
+			for(int i = 0; i < n; i++){
+				for(int j = 0; j < n; j++){
+					//the index of the one spin left
+					sample[__builtin_ctz(M[i][j])]++;
+				}
+			}
+			return start;
+		}
+		failed = start;
+	}
+}